@@ -0,0 +1,89 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+/* Number of right hand sides (boundary configurations) that are solved together.
+Every grid point stores all of them interleaved, such that every kernel handles all
+of them in one pass and every halo exchange carries all of them. Set at compile
+time with -DDASHMG_BATCH=<k>, the default 1 is the plain double version. */
+#ifndef DASHMG_BATCH
+#define DASHMG_BATCH 1
+#endif
+
+constexpr size_t batch_size= DASHMG_BATCH;
+
+/* K values per grid point, the arithmetic is element-wise such that the
+compiler can vectorize along the batch dimension. It needs to stay trivially
+copyable to be usable as element type of DASH containers. */
+template< size_t K >
+struct Batch {
+
+    double v[K];
+
+    Batch() = default;
+
+    /* broadcast a scalar to all lanes, used for all the constant coefficients */
+    Batch( double s ) {
+        for ( size_t k= 0; k < K; ++k ) v[k]= s;
+    }
+
+    Batch& operator+=( const Batch& o ) {
+        for ( size_t k= 0; k < K; ++k ) v[k] += o.v[k];
+        return *this;
+    }
+
+    Batch& operator-=( const Batch& o ) {
+        for ( size_t k= 0; k < K; ++k ) v[k] -= o.v[k];
+        return *this;
+    }
+
+    Batch& operator*=( const Batch& o ) {
+        for ( size_t k= 0; k < K; ++k ) v[k] *= o.v[k];
+        return *this;
+    }
+};
+
+template< size_t K >
+Batch<K> operator+( Batch<K> a, const Batch<K>& b ) { return a += b; }
+
+template< size_t K >
+Batch<K> operator-( Batch<K> a, const Batch<K>& b ) { return a -= b; }
+
+template< size_t K >
+Batch<K> operator*( Batch<K> a, const Batch<K>& b ) { return a *= b; }
+
+template< size_t K >
+Batch<K> operator*( double s, Batch<K> a ) { return a *= Batch<K>( s ); }
+
+template< size_t K >
+Batch<K> operator*( Batch<K> a, double s ) { return a *= Batch<K>( s ); }
+
+template< size_t K >
+Batch<K> operator-( Batch<K> a ) { return a *= Batch<K>( -1.0 ); }
+
+/* maximum norm over all lanes, this is what goes into the global residual */
+template< size_t K >
+double maxabs( const Batch<K>& a ) {
+
+    double ret= 0.0;
+    for ( size_t k= 0; k < K; ++k ) ret= std::max( ret, std::fabs( a.v[k] ) );
+    return ret;
+}
+
+template< size_t K >
+double& lane( Batch<K>& a, size_t k ) { return a.v[k]; }
+
+inline double maxabs( double a ) { return std::fabs( a ); }
+
+inline double& lane( double& a, size_t ) { return a; }
+
+/* element type of all grids */
+using ValueT = typename std::conditional< 1 == batch_size, double, Batch<batch_size> >::type;
+
+static_assert( std::is_trivially_copyable<ValueT>::value, "grid elements need to be trivially copyable" );
+
+#endif /* BATCH_H */
@@ -2,8 +2,34 @@
 
 # if present, the first command line argument is used as a label. It should not contain spaces.
 
-cat overview_0*.csv >"overview"$1".csv"
-rm -Rf overview_0*.csv
+# per unit files, not there with --no-unit-files
+if ls overview_0*.csv >/dev/null 2>&1; then
+    cat overview_0*.csv >"overview"$1".csv"
+    rm -Rf overview_0*.csv
+fi
+
+# call trees per unit
+if ls calltree_0*.csv >/dev/null 2>&1; then
+    cat calltree_0*.csv >"calltree"$1".csv"
+    rm -Rf calltree_0*.csv
+fi
+
+# summary over all units, written by unit 0 only
+if [ -f summary.csv ]; then
+    mv summary.csv "summary"$1".csv"
+fi
+
+# per case files of the ensemble mode
+if ls overview_case*_0*.csv >/dev/null 2>&1; then
+    cat overview_case*_0*.csv >"overview_cases"$1".csv"
+    rm -Rf overview_case*_0*.csv
+fi
+
+# per case summaries over the units of a subteam in ensemble mode
+if ls summary_case*.csv >/dev/null 2>&1; then
+    cat summary_case*.csv >"summary_ensemble"$1".csv"
+    rm -Rf summary_case*.csv
+fi
 `dirname $0`/overview.gnuplot -e "filename='<name_of_tracefile.csv>'"
 
 
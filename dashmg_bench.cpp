@@ -0,0 +1,161 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <vector>
+#include <array>
+
+#include "multigrid.h"
+
+using std::cout;
+using std::endl;
+
+/* Micro benchmark of the single kernels of the solver in isolation, for all
+team sizes All, All/2, ..., 1 and all grid sizes with at least 2 elements per
+unit and dimension. Every configuration runs the kernels warmup times, then
+reps times measured. The results go to bench_00000.csv in the MiniMon format
+with the configuration in the tag column, so they can be compared across
+versions per kernel. The regions of smoothen() are the ones of the solver,
+i.e., smoothen_inner, smoothen_outer, smoothen_wait and so on. */
+
+
+/* benchmark the kernels on a fine level of 2^l -1 elements per dimension and the next
+coarser one. The blocks are planned like in Solver::setup(), such that they stay aligned
+for any number of units. Returns false without running anything if there is no coarser
+level with at least 2 elements per unit and dimension. */
+bool bench_level( dash::Team& team, uint32_t l, uint32_t warmup, uint32_t reps ) {
+
+    MINIMON_REGION( region_initboundary, "initboundary" );
+    MINIMON_REGION( region_halo, "halo_exchange" );
+    MINIMON_REGION( region_allreduce, "allreduce" );
+
+    size_t n= level_extent( l, false );
+    std::array< size_t, 3 > extents= {{ n, n, n }};
+    std::array< double, 3 > h= {{ 1.0/(n+1), 1.0/(n+1), 1.0/(n+1) }};
+    TeamSpecT teamspec= make_teamspec( team.size(), extents, Decomposition() );
+    std::vector<LevelPlan> plan= plan_levels( extents, h, {{ false, false, false }}, teamspec, 2, false, 0.0 );
+    if ( plan.size() < 2 ) return false;
+
+    if ( 0 == dash::myid() ) {
+        cout << "bench " << n << "³ with " << team.size() << " units" << endl;
+    }
+
+    Level fine( 1.0, 1.0, 1.0, n, n, n, team, teamspec, {{ false, false, false }}, plan[0].blocks );
+    Level coarse( fine, plan[1].extents[0], plan[1].extents[1], plan[1].extents[2],
+        team, teamspec, plan[1].blocks );
+    initboundary_zero( coarse );
+
+    Allreduce res( team );
+    uint32_t par= team.size();
+    uint64_t elements= fine.src_grid->local_size();
+    size_t ld= fine.src_grid->local.extent(0);
+    size_t lh= fine.src_grid->local.extent(1);
+    size_t lw= fine.src_grid->local.extent(2);
+    uint64_t halo_bytes= 2*(ld*lh+lh*lw+lw*ld)*sizeof(ValueT);
+
+    for ( uint32_t r= 0; r < warmup + reps; ++r ) {
+
+        /* only measure from here on */
+        if ( r == warmup ) minimon.clear();
+
+        // initboundary
+        minimon.start( region_initboundary );
+        initboundary( fine );
+        minimon.stop( region_initboundary, par, elements );
+
+        smoothen( fine, res );
+
+        scaledown( fine, coarse );
+        scaleup( coarse, fine );
+
+        // halo_exchange
+        minimon.start( region_halo );
+        fine.update_halo_async();
+        fine.wait_halo();
+        minimon.stop( region_halo, par, elements, 0, 0, /* bytes written, faces only */ halo_bytes );
+
+        // allreduce
+        minimon.start( region_allreduce );
+        double localres= 1.0;
+        res.set( &localres, team );
+        res.collect_and_spread( team );
+        res.wait( team );
+        minimon.stop( region_allreduce, par );
+    }
+
+    team.barrier();
+    return true;
+}
+
+
+int main( int argc, char* argv[] ) {
+
+    dash::init( &argc, &argv );
+
+    uint32_t minlevels= 3;
+    uint32_t maxlevels= 7;
+    uint32_t warmup= 3;
+    uint32_t reps= 20;
+
+    for ( int a= 1; a < argc; a++ ) {
+
+        if ( 0 == strncmp( "-h", argv[a], 2 ) || 0 == strncmp( "--help", argv[a], 6 ) ) {
+
+            if ( 0 == dash::myid() ) {
+                cout << "\n Call me as 'mpirun " << argv[0] << " [-l <min> <max>] [-w <warmup>] [-r <reps>]'\n\n"
+                    " -l <min> <max> range of levels, the grids have 2^l -1 inner elements\n"
+                    "                per dimension (default " << minlevels << " " << maxlevels << ")\n"
+                    " -w <warmup>    unmeasured runs per configuration (default " << warmup << ")\n"
+                    " -r <reps>      measured runs per configuration (default " << reps << ")\n\n";
+            }
+            dash::finalize();
+            return 0;
+
+        } else if ( 0 == strcmp( "-l", argv[a] ) && ( a+2 < argc ) ) {
+
+            minlevels= atoi( argv[a+1] );
+            maxlevels= atoi( argv[a+2] );
+            a += 2;
+
+        } else if ( 0 == strcmp( "-w", argv[a] ) && ( a+1 < argc ) ) {
+
+            warmup= atoi( argv[a+1] );
+            a += 1;
+
+        } else if ( 0 == strcmp( "-r", argv[a] ) && ( a+1 < argc ) ) {
+
+            reps= atoi( argv[a+1] );
+            a += 1;
+        }
+    }
+
+    assert( 2 <= minlevels );
+
+    /* the units outside of the subteam of unit 0 run the same configurations
+    concurrently, such that the node is loaded as in a real run */
+    dash::Team* team= &dash::Team::All();
+    bool append= false;
+    while ( true ) {
+
+        for ( uint32_t l= minlevels; l <= maxlevels; ++l ) {
+
+            if ( ! bench_level( *team, l, warmup, reps ) ) continue;
+
+            if ( 0 == dash::myid() ) {
+                minimon.print( 0, { "bench", "units=" + std::to_string( team->size() ),
+                    "levels=" + std::to_string( l ), "batch=" + std::to_string( batch_size ) },
+                    "bench", append );
+                append= true;
+            }
+            minimon.clear();
+        }
+
+        if ( 1 == team->size() ) break;
+        team= &team->split( 2 );
+    }
+
+    dash::finalize();
+
+    return 0;
+}
@@ -3,12 +3,31 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
 #include <vector>
 #include <deque>
 #include <stack>
 #include <chrono>
 #include <map>
 #include <tuple>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <csignal>
+#include <ctime>
+#include <sys/stat.h>
+
+#include <mpi.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif /* __linux__ */
 
 static std::ofstream& operator<<(std::ofstream& ofs, const std::vector<std::string>& args) {
    std::string sep = "";
@@ -24,54 +43,518 @@ class MiniMon {
 
 public:
 
-    MiniMon() = default;
+    /* index of a registered region, see region() and MINIMON_REGION */
+    using Handle = uint32_t;
+
+    /* hardware counters per region, see enable_counters() */
+    enum { CYCLES, INSTRUCTIONS, LLC_MISSES, DTLB_MISSES, FP_VECTOR, NUM_COUNTERS };
+    using counters_t = std::array<uint64_t,NUM_COUNTERS>;
+
+    MiniMon() {
+
+        std::vector<MiniMonEntry> entries;
+        entries.reserve( 64 );
+        _entries= std::stack<MiniMonEntry, std::vector<MiniMonEntry>>( std::move( entries ) );
+        _counter_pos.fill( -1 );
+        _begin= std::chrono::high_resolution_clock::now();
+
+        /* root of the call tree */
+        _nodes.emplace_back( NO_HANDLE, 0 );
+    }
+
+    ~MiniMon() {
+
+#ifdef __linux__
+        for ( int fd : _counter_fds ) close( fd );
+#endif /* __linux__ */
+    }
+
+    /* Open Linux perf_event counters for the calling thread: cycles, instructions,
+    last level cache misses, dTLB load misses, and FP vector operations if a raw event
+    code for them is given in the environment variable MINIMON_PERF_RAW (it is model
+    specific, e.g. 0x3cc7 for FP_ARITH_INST_RETIRED.256B_PACKED_DOUBLE on Intel cores).
+    Every region then gets the counts between start() and stop(). Counters that can not
+    be opened are reported as 0. Returns false if no counters at all are permitted,
+    e.g. because of /proc/sys/kernel/perf_event_paranoid, then nothing changes. */
+    bool enable_counters() {
+
+#ifdef __linux__
+        struct Event { uint32_t type; uint64_t config; };
+        std::array<Event,NUM_COUNTERS> events= {{
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ) },
+            { PERF_TYPE_RAW, 0 } }};
+
+        const char* raw= std::getenv( "MINIMON_PERF_RAW" );
+        if ( nullptr != raw ) events[FP_VECTOR].config= std::strtoull( raw, nullptr, 0 );
+
+        int leader= -1;
+        for ( uint32_t i= 0; i < NUM_COUNTERS; ++i ) {
+
+            if ( PERF_TYPE_RAW == events[i].type && 0 == events[i].config ) continue;
+
+            struct perf_event_attr attr;
+            std::fill( (char*) &attr, (char*) &attr + sizeof(attr), 0 );
+            attr.type= events[i].type;
+            attr.size= sizeof(attr);
+            attr.config= events[i].config;
+            attr.disabled= ( -1 == leader ) ? 1 : 0;
+            attr.exclude_kernel= 1;
+            attr.exclude_hv= 1;
+            attr.read_format= PERF_FORMAT_GROUP;
+
+            int fd= syscall( __NR_perf_event_open, &attr, 0, -1, leader, 0 );
+            if ( 0 > fd ) continue;
+
+            if ( -1 == leader ) leader= fd;
+            _counter_pos[i]= _counter_fds.size();
+            _counter_fds.push_back( fd );
+        }
+
+        if ( -1 == leader ) return false;
+
+        ioctl( leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+        ioctl( leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+        return true;
+#else
+        return false;
+#endif /* __linux__ */
+    }
+
+    /* Record every stop() as an event with begin and end time into a ring buffer
+    of n entries, allocated here once. When more events occur, the oldest ones are
+    overwritten. The time stamps count from here, so calling it on all units right
+    after a barrier aligns their timelines. See print_trace(). */
+    void enable_trace( size_t n= 1<<20 ) {
+
+        _trace.assign( n, MiniMonEvent() );
+        _trace_next= 0;
+        _begin= std::chrono::high_resolution_clock::now();
+    }
+
+    /* global grid extents of the level that the following events belong to, all 0 for
+    none, see print_trace(). Returns the previous ones, such that a nested level can
+    restore them at its end. */
+    using grid_t = std::array<uint32_t,3>;
+    grid_t trace_grid( const grid_t& g ) {
+
+        grid_t old= _grid;
+        _grid= g;
+        return old;
+    }
+
+    /* register a region name once and get the handle for the fast stop(),
+    registering the same name again returns the same handle */
+    Handle region( const std::string& n ) {
+
+        auto it= _handles.find( n );
+        if ( _handles.end() != it ) return it->second;
+
+        Handle h= _regions.size();
+        _regions.emplace_back( n );
+        _handles[ n ]= h;
+        return h;
+    }
+
+    /* start a region, with the handle it is placed in the call tree right away,
+    such that regions started inside of it get the full path. Without it, the
+    region is placed at stop() and its own nested regions end up at the root. */
+    void start( Handle h ) {
+
+        uint32_t parent= _entries.empty() ? 0 : _entries.top().node;
+        if ( UNRESOLVED == parent ) parent= 0;
+
+        MiniMonEntry entry;
+        entry.node= child( parent, h );
+        entry.child_time= 0.0;
+        entry.counted= read_counters( entry.counters );
+        entry.time= std::chrono::high_resolution_clock::now();
+        _entries.push( entry );
+    }
+
+    void start( const std::string& n ) {
+
+        start( region( n ) );
+    }
 
     void start() {
 
-        _entries.push(std::chrono::high_resolution_clock::now());
+        MiniMonEntry entry;
+        entry.node= UNRESOLVED;
+        entry.child_time= 0.0;
+        entry.counted= read_counters( entry.counters );
+        entry.time= std::chrono::high_resolution_clock::now();
+        _entries.push( entry );
     }
 
-    void stop( const std::string& n, uint32_t p, uint64_t e = 1,
+    /* fast path: no string handling and no allocation once the region has seen
+    the combination of p, e, f before.
+    p is the parallelism, e the number of elements, f the flops, r and w the bytes
+    read and written by the region. */
+    void stop( Handle h, uint32_t p, uint64_t e = 1,
                uint64_t f = 0, uint64_t r = 0, uint64_t w = 0 ) {
 
-        auto& top = _entries.top();
-        _store[ {n,p,e,f} ].apply( std::chrono::high_resolution_clock::now() - top );
+        const MiniMonEntry top = _entries.top();
         _entries.pop();
+
+        auto& value= _regions[ h ].slot( p, e, f );
+        time_point_t end= std::chrono::high_resolution_clock::now();
+        time_diff_t duration= end - top.time;
+        value.apply( duration, f, r, w );
+        if ( ! _trace.empty() ) {
+            _trace[ _trace_next++ % _trace.size() ]= { h, p, e, _grid, top.time, end };
+        }
+        counters_t now;
+        if ( top.counted && read_counters( now ) ) {
+            for ( uint32_t i= 0; i < NUM_COUNTERS; ++i ) value.counters[i] += now[i] - top.counters[i];
+        }
+
+        /* call tree, the time of this region is not exclusive time of the parent */
+        uint32_t node= top.node;
+        if ( UNRESOLVED == node ) {
+            uint32_t parent= _entries.empty() ? 0 : _entries.top().node;
+            node= child( UNRESOLVED == parent ? 0 : parent, h );
+        }
+        _nodes[ node ].apply( duration.count(), duration.count() - top.child_time );
+        if ( ! _entries.empty() ) _entries.top().child_time += duration.count();
+    }
+
+    void stop( const std::string& n, uint32_t p, uint64_t e = 1,
+               uint64_t f = 0, uint64_t r = 0, uint64_t w = 0 ) {
+
+        stop( region( n ), p, e, f, r, w );
+    }
+
+    /* record a plain value like an iteration count instead of a time
+    measurement, it shows up in the runtime columns of the output */
+    void record( Handle h, uint32_t p, uint64_t e, double v ) {
+
+        _regions[ h ].slot( p, e, 0 ).apply( time_diff_t( v ), 0, 0, 0 );
+    }
+
+    void record( const std::string& n, uint32_t p, uint64_t e, double v ) {
+
+        record( region( n ), p, e, v );
     }
 
     double get(const std::string& n) {
         double res = 0.0;
-        const auto it = _store.lower_bound({n,0,0,0});
-        const auto itend = _store.upper_bound({n,UINT32_MAX,UINT32_MAX,UINT64_MAX});
-        while (it != itend)
-            res += it->second.runtime_sum.count();
+        const auto it = _handles.find( n );
+        if ( _handles.end() == it ) return res;
+        for ( const auto& s : _regions[ it->second ].slots )
+            res += s.value.runtime_sum.count();
         return res;
     }
 
-    void print(uint32_t id, const std::vector<std::string>& tags) const {
+    /* runtime sum and number of calls of a region per par and elements, e.g. per
+    grid level for the smoothing regions */
+    std::map< std::pair<uint32_t,uint64_t>, std::pair<double,double> > get_slots(const std::string& n) {
+        std::map< std::pair<uint32_t,uint64_t>, std::pair<double,double> > res;
+        const auto it = _handles.find( n );
+        if ( _handles.end() == it ) return res;
+        for ( const auto& s : _regions[ it->second ].slots ) {
+            auto& r = res[ std::make_pair( s.par, s.elements ) ];
+            r.first += s.value.runtime_sum.count();
+            r.second += s.value.num;
+        }
+        return res;
+    }
+
+    /* sum of the elements over all calls of a region, e.g. all grid points
+    touched by the smoothing sweeps so far */
+    double get_elements(const std::string& n) {
+        double res = 0.0;
+        const auto it = _handles.find( n );
+        if ( _handles.end() == it ) return res;
+        for ( const auto& s : _regions[ it->second ].slots )
+            res += (double) s.elements * s.value.num;
+        return res;
+    }
+
+    /* Measure the memory bandwidth available to this unit with a STREAM triad
+    on n doubles per array, the best of reps runs counts. When all units on a node
+    call this at the same time, the result is the fair share per unit under full
+    load, which is the relevant ceiling for the kernels. Returns GB/s, print() then
+    relates the bandwidth of every region to it. */
+    double measure_bandwidth( size_t n= 1<<24, uint32_t reps= 5 ) {
+
+        std::vector<double> a( n, 0.0 ), b( n, 1.0 ), c( n, 2.0 );
+        const double scalar= 3.0;
+
+        time_diff_t best( 1.0e300 );
+        for ( uint32_t i= 0; i < reps; ++i ) {
+
+            time_point_t start= std::chrono::high_resolution_clock::now();
+            for ( size_t j= 0; j < n; ++j ) a[j]= b[j] + scalar * c[j];
+            best= std::min( best, time_diff_t( std::chrono::high_resolution_clock::now() - start ) );
+        }
+
+        /* keep the compiler from dropping the loop */
+        volatile double sink= a[n/2];
+        (void) sink;
+
+        _stream_gbs= 3.0 * sizeof(double) * n / best.count() / 1.0e9;
+        return _stream_gbs;
+    }
+
+    /* drop all measurements so far, e.g. after printing them for one case of an
+    ensemble run. Regions that are still open and the registered handles are
+    not affected. */
+    void clear() {
+
+        for ( auto& r : _regions ) {
+            r.slots.clear();
+            r.last= 0;
+        }
+        for ( auto& n : _nodes ) {
+            n.inclusive= n.exclusive= 0.0;
+            n.num= 0;
+        }
+    }
+
+    /* Write the call tree to prefix_<id>.csv, one line per path of nested regions
+    from the outermost one, e.g. main/algorithm/smoothen, with inclusive and exclusive
+    (without nested regions) runtime, and the fraction of the inclusive runtime of the
+    parent. Paths are only complete for regions started with start( handle ). */
+    void print_calltree( uint32_t id, const std::vector<std::string>& tags,
+                         const std::string& prefix= "calltree" ) const {
+
+        std::ofstream file;
+        std::ostringstream file_name;
+        file_name << prefix << "_" << std::setw(5) << std::setfill('0') << id << ".csv";
+        file.open(file_name.str());
+
+        file << "# tag;path;depth;num_calls;inclusive_runtime;exclusive_runtime;fraction_of_parent" << std::endl;
+
+        /* depth first, the children in the order they were seen first */
+        std::vector<std::pair<uint32_t,std::string>> todo;
+        for ( auto c= _nodes[0].children.rbegin(); c != _nodes[0].children.rend(); ++c ) {
+            todo.emplace_back( *c, "" );
+        }
+        while ( ! todo.empty() ) {
+
+            uint32_t n= todo.back().first;
+            std::string path= todo.back().second + _regions[ _nodes[n].handle ].name;
+            todo.pop_back();
+
+            const MiniMonNode& node= _nodes[n];
+            const MiniMonNode& parent= _nodes[node.parent];
+            uint32_t depth= std::count( path.begin(), path.end(), '/' );
+            if ( 0 < node.num ) {
+                file << tags << ";" <<
+                    path << ";" <<
+                    depth << ";" <<
+                    node.num << ";" <<
+                    node.inclusive << ";" <<
+                    node.exclusive << ";" <<
+                    ( 0.0 < parent.inclusive ? node.inclusive / parent.inclusive : 1.0 ) << std::endl;
+            }
+
+            for ( auto c= node.children.rbegin(); c != node.children.rend(); ++c ) {
+                todo.emplace_back( *c, path + "/" );
+            }
+        }
+        file.close();
+    }
+
+    /* with append, add to an existing file without repeating the header */
+    void print(uint32_t id, const std::vector<std::string>& tags,
+               const std::string& prefix= "overview", bool append= false) const {
         /* print out log to individual files */
 
         {
             std::ofstream file;
             std::ostringstream file_name;
-            file_name << "overview_" << std::setw(5) << std::setfill('0') << id << ".csv";
-            file.open(file_name.str());
+            file_name << prefix << "_" << std::setw(5) << std::setfill('0') << id << ".csv";
+            file.open(file_name.str(), append ? std::ios::app : std::ios::out);
+
+            if ( 0 == file.tellp() ) print_header( file );
+            print_rows( file, tags );
+            file.close();
+        }
+    }
 
-            file << "# tag;function_name;par;elements;flops;num_calls;avg_runtime;min_runtime;max_runtime"
-                 << std::endl;
+    /* Ask for a snapshot with SIGUSR1 to the processes, or by touching flagfile
+    (if not empty), see snapshot_requested(). */
+    void enable_snapshots( const std::string& flagfile ) {
 
-            for (auto& e : _store) {
-                file << tags << ";" <<
-                    std::get<0>(e.first) << ";" <<
-                    std::get<1>(e.first) << ";" <<
-                    std::get<2>(e.first) << ";" <<
-                    std::get<3>(e.first) << ";" <<
-                    e.second.num << ";" <<
-                    e.second.runtime_sum.count() / e.second.num << ";" <<
-                    e.second.runtime_min.count() << ";" <<
-                    e.second.runtime_max.count() << std::endl;
+        signal( SIGUSR1, &MiniMon::snapshot_signal_handler );
+        _flagfile= flagfile;
+        _flagfile_mtime= flagfile_mtime();
+        _flagfile_polled= std::chrono::high_resolution_clock::now();
+    }
+
+    /* Cheap enough to be called in every sweep: true once after SIGUSR1 was received
+    or the flag file was modified. The flag file is checked at most once per second.
+    Every unit decides on its own, so this needs no communication. */
+    bool snapshot_requested() {
+
+        if ( snapshot_signal() ) {
+            snapshot_signal()= 0;
+            return true;
+        }
+
+        if ( _flagfile.empty() ) return false;
+
+        time_point_t now= std::chrono::high_resolution_clock::now();
+        if ( time_diff_t( now - _flagfile_polled ).count() < 1.0 ) return false;
+        _flagfile_polled= now;
+
+        time_t mtime= flagfile_mtime();
+        if ( mtime == _flagfile_mtime ) return false;
+        _flagfile_mtime= mtime;
+        return true;
+    }
+
+    /* Append the current aggregates of this unit to prefix_<id>.csv in the format
+    of print(), with the time since enable_snapshots() and the given tags, e.g. the
+    current residual, in the tag column. Regions that are still open are missing. */
+    void snapshot( uint32_t id, std::vector<std::string> tags,
+                   const std::string& prefix= "snapshot" ) const {
+
+        std::ofstream file;
+        std::ostringstream file_name;
+        file_name << prefix << "_" << std::setw(5) << std::setfill('0') << id << ".csv";
+        file.open(file_name.str(), std::ios::app);
+
+        if ( 0 == file.tellp() ) print_header( file );
+
+        tags.insert( tags.begin(), "time=" +
+            std::to_string( time_diff_t( std::chrono::high_resolution_clock::now() - _begin ).count() ) );
+        print_rows( file, tags );
+        file.close();
+    }
+
+    /* Write the events recorded since enable_trace() to prefix_<id>.json in the
+    Chrome trace event format, which can be loaded by chrome://tracing and by
+    Perfetto. Every unit is a process there, the events carry par (the team size),
+    elements (the local grid size), and grid (the global extents of the level, see
+    trace_grid()), which identifies the level on all units. */
+    void print_trace( uint32_t id, const std::string& prefix= "trace" ) const {
+
+        if ( _trace.empty() ) return;
+
+        std::ofstream file;
+        std::ostringstream file_name;
+        file_name << prefix << "_" << std::setw(5) << std::setfill('0') << id << ".json";
+        file.open(file_name.str());
+
+        file << "{\"traceEvents\":[" << std::endl;
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << id <<
+            ",\"args\":{\"name\":\"unit " << id << "\"}}";
+
+        /* oldest first, the buffer may have wrapped around */
+        size_t n= std::min( _trace_next, _trace.size() );
+        for ( size_t i= _trace_next - n; i < _trace_next; ++i ) {
+
+            const MiniMonEvent& ev= _trace[ i % _trace.size() ];
+            file << "," << std::endl << std::fixed << std::setprecision( 3 ) <<
+                "{\"name\":\"" << _regions[ ev.handle ].name << "\",\"ph\":\"X\",\"pid\":" << id <<
+                ",\"tid\":0,\"ts\":" << time_diff_t( ev.begin - _begin ).count() * 1.0e6 <<
+                ",\"dur\":" << time_diff_t( ev.end - ev.begin ).count() * 1.0e6 <<
+                ",\"args\":{\"par\":" << ev.par << ",\"elements\":" << ev.elements;
+            if ( 0 < ev.grid[0] ) {
+                file << ",\"grid\":\"" << ev.grid[0] << "x" << ev.grid[1] << "x" << ev.grid[2] << "\"";
+            }
+            file << "}}";
+        }
+        file << std::endl << "]}" << std::endl;
+        file.close();
+    }
+
+    /* Reduce the measurements of all units in comm to the unit with rank 0 there,
+    which writes a single file prefix.csv with one line per region and par: the total
+    runtime per unit as min, mean and max over the units that ran the region, the
+    unit with the max, and the imbalance factor max/mean. This replaces reading one
+    overview file per unit which does not scale to many units. Collective, so it
+    needs to be called before MPI is finalized. */
+    void print_summary( MPI_Comm comm, const std::vector<std::string>& tags,
+                        const std::string& prefix= "summary" ) const {
+
+        int rank, size;
+        MPI_Comm_rank( comm, &rank );
+        MPI_Comm_size( comm, &size );
+
+        /* per unit totals over all slots of a region with the same par */
+        std::map<std::pair<std::string,uint32_t>,std::pair<double,uint64_t>> local;
+        for ( const auto& r : _regions ) {
+            for ( const auto& s : r.slots ) {
+                auto& t= local[ std::make_pair( r.name, s.par ) ];
+                t.first += s.value.runtime_sum.count();
+                t.second += s.value.num;
+            }
+        }
+
+        /* names are of different lengths, so send one text line per region */
+        std::ostringstream lines;
+        lines << std::setprecision( 17 );
+        for ( const auto& l : local ) {
+            lines << l.first.first << ";" << l.first.second << ";" <<
+                l.second.first << ";" << l.second.second << "\n";
+        }
+        const std::string buf= lines.str();
+
+        int len= buf.size();
+        std::vector<int> lens( 0 == rank ? size : 0 );
+        MPI_Gather( &len, 1, MPI_INT, lens.data(), 1, MPI_INT, 0, comm );
+
+        std::vector<int> displs( lens.size(), 0 );
+        for ( size_t i= 1; i < lens.size(); ++i ) displs[i]= displs[i-1] + lens[i-1];
+        std::vector<char> all( lens.empty() ? 0 : displs.back() + lens.back() );
+        MPI_Gatherv( buf.data(), len, MPI_CHAR,
+            all.data(), lens.data(), displs.data(), MPI_CHAR, 0, comm );
+
+        if ( 0 != rank ) return;
+
+        struct Summary {
+            double min= 1.0e300;
+            double max= 0.0;
+            double sum= 0.0;
+            uint64_t calls= 0;
+            uint32_t units= 0;
+            int slowest= 0;
+        };
+        std::map<std::pair<std::string,uint32_t>,Summary> summary;
+
+        for ( int u= 0; u < size; ++u ) {
+
+            std::istringstream unit( std::string( all.data() + displs[u], lens[u] ) );
+            std::string name, par, runtime, calls;
+            while ( std::getline( unit, name, ';' ) && std::getline( unit, par, ';' ) &&
+                    std::getline( unit, runtime, ';' ) && std::getline( unit, calls ) ) {
+
+                auto& e= summary[ std::make_pair( name, (uint32_t) std::stoul( par ) ) ];
+                double t= std::stod( runtime );
+                if ( t > e.max ) {
+                    e.max= t;
+                    e.slowest= u;
+                }
+                e.min= std::min( e.min, t );
+                e.sum += t;
+                e.calls += std::stoull( calls );
+                e.units += 1;
             }
-            file.close();
+        }
+
+        std::ofstream file( prefix + ".csv" );
+        file << "# tag;function_name;par;units;num_calls;min_runtime;mean_runtime;max_runtime;"
+                "slowest_unit;imbalance" << std::endl;
+        for ( const auto& e : summary ) {
+
+            double mean= e.second.sum / e.second.units;
+            file << tags << ";" <<
+                e.first.first << ";" <<
+                e.first.second << ";" <<
+                e.second.units << ";" <<
+                e.second.calls << ";" <<
+                e.second.min << ";" <<
+                mean << ";" <<
+                e.second.max << ";" <<
+                e.second.slowest << ";" <<
+                ( 0.0 < mean ? e.second.max / mean : 1.0 ) << std::endl;
         }
     }
 
@@ -85,21 +568,252 @@ private:
         time_diff_t runtime_min;
         time_diff_t runtime_max;
         uint32_t num;
+        /* accumulated flops and bytes over all calls */
+        double flops_sum;
+        double read_sum;
+        double written_sum;
+        /* accumulated hardware counters */
+        counters_t counters;
      //std::numeric_limits<int>::max()
-        MiniMonValue( ) : runtime_sum(0.0), runtime_min(1.0e300), runtime_max(0.0), num(0) {}
+        MiniMonValue( ) : runtime_sum(0.0), runtime_min(1.0e300), runtime_max(0.0), num(0),
+            flops_sum(0.0), read_sum(0.0), written_sum(0.0) {
+            counters.fill( 0 );
+        }
 
-        void apply( time_diff_t value ) {
+        void apply( time_diff_t value, uint64_t f, uint64_t r, uint64_t w ) {
 
             runtime_sum += value;
             runtime_min= std::min( runtime_min, value );
             runtime_max= std::max( runtime_max, value );
             num += 1;
+            flops_sum += f;
+            read_sum += r;
+            written_sum += w;
+        }
+
+        double gflops() const {
+            return ( 0.0 < runtime_sum.count() ) ? flops_sum / runtime_sum.count() / 1.0e9 : 0.0;
+        }
+
+        double gbytes() const {
+            return ( 0.0 < runtime_sum.count() ) ? ( read_sum + written_sum ) / runtime_sum.count() / 1.0e9 : 0.0;
+        }
+
+        /* arithmetic intensity in flops per byte, for the roofline model */
+        double intensity() const {
+            return ( 0.0 < read_sum + written_sum ) ? flops_sum / ( read_sum + written_sum ) : 0.0;
+        }
+    };
+
+    /* an open region on the stack */
+    struct MiniMonEntry {
+
+        time_point_t time;
+        counters_t counters;
+        bool counted;
+        /* position in the call tree and runtime of the nested regions so far */
+        uint32_t node;
+        double child_time;
+    };
+
+    /* the root of the call tree has no region, entries of start() without handle
+    are placed in the tree at stop() */
+    enum : uint32_t { NO_HANDLE= ~0u, UNRESOLVED= ~0u };
+
+    /* one node of the call tree per path of handles from the root */
+    struct MiniMonNode {
+
+        Handle handle;
+        uint32_t parent;
+        std::vector<uint32_t> children;
+        double inclusive= 0.0;
+        double exclusive= 0.0;
+        uint64_t num= 0;
+
+        MiniMonNode( Handle h, uint32_t p ) : handle( h ), parent( p ) {}
+
+        void apply( double incl, double excl ) {
+
+            inclusive += incl;
+            exclusive += excl;
+            num += 1;
+        }
+    };
+
+    /* find or create the node for handle h below node parent,
+    there are only a few children per node, so search linearly */
+    uint32_t child( uint32_t parent, Handle h ) {
+
+        for ( uint32_t c : _nodes[ parent ].children ) {
+            if ( h == _nodes[ c ].handle ) return c;
+        }
+        uint32_t c= _nodes.size();
+        _nodes.emplace_back( h, parent );
+        _nodes[ parent ].children.push_back( c );
+        return c;
+    }
+
+    /* one event of the trace, see enable_trace() */
+    struct MiniMonEvent {
+
+        Handle handle;
+        uint32_t par;
+        uint64_t elements;
+        grid_t grid;
+        time_point_t begin;
+        time_point_t end;
+    };
+
+    /* one entry per combination of par, elements, flops seen for a region */
+    struct MiniMonSlot {
+
+        uint32_t par;
+        uint64_t elements;
+        uint64_t flops;
+        MiniMonValue value;
+    };
+
+    struct MiniMonRegion {
+
+        std::string name;
+        std::vector<MiniMonSlot> slots;
+        /* the slot used last time, most consecutive calls hit the same one */
+        size_t last;
+
+        explicit MiniMonRegion( const std::string& n ) : name( n ), last( 0 ) {}
+
+        /* there are only few slots per region, one per grid level at most,
+        so a linear search is fine */
+        MiniMonValue& slot( uint32_t p, uint64_t e, uint64_t f ) {
+
+            if ( last < slots.size() && match( slots[last], p, e, f ) ) return slots[last].value;
+
+            for ( last= 0; last < slots.size(); ++last ) {
+                if ( match( slots[last], p, e, f ) ) return slots[last].value;
+            }
+
+            slots.push_back( { p, e, f, MiniMonValue() } );
+            return slots.back().value;
+        }
+
+        static bool match( const MiniMonSlot& s, uint32_t p, uint64_t e, uint64_t f ) {
+
+            return s.par == p && s.elements == e && s.flops == f;
         }
     };
 
+    std::vector<MiniMonRegion> _regions;
+    /* STREAM triad bandwidth in GB/s, 0.0 if not measured */
+    double _stream_gbs= 0.0;
+    std::map<std::string,Handle> _handles;
+    std::stack<MiniMonEntry, std::vector<MiniMonEntry>> _entries;
+
+    /* the call tree, node 0 is the root */
+    std::vector<MiniMonNode> _nodes;
+
+    /* flag file for snapshots, the last modification time seen and the time of
+    the last check */
+    std::string _flagfile;
+    time_t _flagfile_mtime= 0;
+    time_point_t _flagfile_polled;
+
+    /* set by the signal handler, there is only one per process anyway */
+    static volatile sig_atomic_t& snapshot_signal() {
+
+        static volatile sig_atomic_t requested= 0;
+        return requested;
+    }
+
+    static void snapshot_signal_handler( int ) {
+
+        snapshot_signal()= 1;
+    }
+
+    time_t flagfile_mtime() const {
+
+        struct stat st;
+        return ( 0 == stat( _flagfile.c_str(), &st ) ) ? st.st_mtime : 0;
+    }
+
+    void print_header( std::ofstream& file ) const {
+
+        file << "# tag;function_name;par;elements;flops;num_calls;avg_runtime;min_runtime;max_runtime;"
+                "gflops_per_s;gbytes_per_s;flops_per_byte;stream_fraction;"
+                "avg_cycles;avg_instructions;avg_llc_misses;avg_dtlb_misses;avg_fp_vector_ops"
+             << std::endl;
+    }
+
+    void print_rows( std::ofstream& file, const std::vector<std::string>& tags ) const {
+
+        /* only here the keys are materialized, sorted like before by name first */
+        std::map<std::tuple<std::string,uint32_t,uint64_t,uint64_t>,const MiniMonValue*> store;
+        for ( const auto& r : _regions ) {
+            for ( const auto& s : r.slots ) {
+                store[ std::make_tuple( r.name, s.par, s.elements, s.flops ) ]= &s.value;
+            }
+        }
+
+        for (auto& e : store) {
+            file << tags << ";" <<
+                std::get<0>(e.first) << ";" <<
+                std::get<1>(e.first) << ";" <<
+                std::get<2>(e.first) << ";" <<
+                std::get<3>(e.first) << ";" <<
+                e.second->num << ";" <<
+                e.second->runtime_sum.count() / e.second->num << ";" <<
+                e.second->runtime_min.count() << ";" <<
+                e.second->runtime_max.count() << ";" <<
+                e.second->gflops() << ";" <<
+                e.second->gbytes() << ";" <<
+                e.second->intensity() << ";" <<
+                ( 0.0 < _stream_gbs ? e.second->gbytes() / _stream_gbs : 0.0 );
+            for ( uint64_t c : e.second->counters ) {
+                file << ";" << c / e.second->num;
+            }
+            file << std::endl;
+        }
+    }
+
+    /* ring buffer of events, empty if tracing is off */
+    std::vector<MiniMonEvent> _trace;
+    size_t _trace_next= 0;
+    grid_t _grid= {{ 0, 0, 0 }};
+    time_point_t _begin;
+
+    /* the perf_event file descriptors, the first one is the group leader,
+    and the position of every counter in the group or -1 */
+    std::vector<int> _counter_fds;
+    std::array<int,NUM_COUNTERS> _counter_pos;
+
+    /* one read() of the whole counter group, false if counters are not enabled */
+    bool read_counters( counters_t& c ) {
 
-    std::map<std::tuple<std::string,uint32_t,uint64_t,uint64_t>,MiniMonValue> _store;
-    std::stack<time_point_t, std::vector<time_point_t>> _entries;
+#ifdef __linux__
+        if ( _counter_fds.empty() ) return false;
+
+        /* layout for PERF_FORMAT_GROUP: number of values, then the values */
+        uint64_t buf[ 1 + NUM_COUNTERS ];
+        if ( 0 >= read( _counter_fds.front(), buf, sizeof(buf) ) ) return false;
+
+        for ( uint32_t i= 0; i < NUM_COUNTERS; ++i ) {
+            c[i]= ( 0 <= _counter_pos[i] ) ? buf[ 1 + _counter_pos[i] ] : 0;
+        }
+        return true;
+#else
+        return false;
+#endif /* __linux__ */
+    }
 };
 
+/* Declare a static region handle, such that the region name is registered only
+once per call site and MiniMon::stop() does no string handling. Use it like
+
+    MINIMON_REGION( region_smoothen, "smoothen" );
+    minimon.start( region_smoothen );
+    ...
+    minimon.stop( region_smoothen, par, elements, flops );
+*/
+#define MINIMON_REGION( handle, name ) \
+    static const MiniMon::Handle handle= minimon.region( name )
+
 #endif /* MINIMONITORING_H */
@@ -0,0 +1,1998 @@
+#include <unistd.h>
+#include <iostream>
+#include <cstddef>
+#include <iomanip>
+#include <cassert>
+#include <vector>
+#include <cstdio>
+#include <utility>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <math.h>
+
+#include "multigrid.h"
+
+/* TODOs
+
+- add clean version of the code:
+    - without asserts
+    - with simple loops, no optimization for contiguous lines, etc.
+
+*/
+
+MiniMon minimon;
+Progress progress;
+
+using std::cout;
+using std::setfill;
+using std::setw;
+using std::cerr;
+using std::endl;
+using std::setw;
+using std::vector;
+
+
+/* Marks the trace events of a scope with the global extents of a level, in the order
+of the cycle_<nx>x<ny>x<nz> regions, see MiniMon::trace_grid(). At the end of the
+scope the extents of the enclosing level are restored. */
+struct TraceLevel {
+
+    explicit TraceLevel( const Level& level ) : _old( minimon.trace_grid( {{ (uint32_t) level.src_grid->extent(2),
+        (uint32_t) level.src_grid->extent(1), (uint32_t) level.src_grid->extent(0) }} ) ) {}
+    ~TraceLevel() { minimon.trace_grid( _old ); }
+
+    MiniMon::grid_t _old;
+};
+
+
+/* number of inner grid points per dimension for level l, this is 2^l -1 for the
+full grid and 2^(l-1) for the lower half including the center plane in symmetry mode */
+size_t level_extent( uint32_t l, bool mirror ) {
+
+    return mirror ? ( 1<<(l-1) ) : ( 1<<l ) -1;
+}
+
+
+/* predicted time of one halo exchange of the unit with the most neighbors for an
+extents grid on p units per dimension. The 26-point halo has one region per neighbor
+in any combination of directions, faces, edges and corners, that is the block grown
+by 1 on every side with a neighbor, minus the block. */
+static double halo_cost( const std::array< size_t, 3 >& extents, const std::array< size_t, 3 >& p,
+        const Decomposition& decomposition ) {
+
+    double regions= 1.0;
+    double grown= 1.0;
+    double block= 1.0;
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        size_t b= ( extents[d] + p[d] - 1 ) / p[d];
+        size_t sides= std::min( p[d]-1, (size_t) 2 );
+        regions *= 1 + sides;
+        grown *= b + sides;
+        block *= b;
+    }
+
+    double messages= regions - 1.0;
+    double elements= grown - block;
+
+    return messages * decomposition.latency + elements * sizeof(ValueT) / decomposition.bandwidth;
+}
+
+
+/* whether p units per dimension give at least 2 elements per unit */
+static bool valid_units( const std::array< size_t, 3 >& extents, const std::array< size_t, 3 >& p ) {
+
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        if ( extents[d] < 2*p[d] ) return false;
+    }
+    return true;
+}
+
+
+/* The unit arrangement for a team of the given size working on levels starting with
+the given extents, see Decomposition. The blocks of consecutive levels of the same team
+need to stay aligned, therefore the arrangement is chosen once per team for its finest
+level, see plan_levels(). EXPLICIT with another number of units, e.g., for the subteams
+in elastic mode, or with less than 2 elements per unit, and AUTO without any valid
+candidate fall back to BALANCED. */
+TeamSpecT make_teamspec( size_t units, const std::array< size_t, 3 >& extents,
+        const Decomposition& decomposition ) {
+
+    TeamSpecT balanced( units, 1, 1 );
+    balanced.balance_extents();
+
+    if ( Decomposition::EXPLICIT == decomposition.mode ) {
+
+        const auto& p= decomposition.units;
+        if ( p[0] * p[1] * p[2] == units ) {
+
+            if ( valid_units( extents, p ) ) return TeamSpecT( p[0], p[1], p[2] );
+
+            if ( 0 == dash::myid() ) {
+                cout << "units arranged as " << p[0] << "×" << p[1] << "×" << p[2] <<
+                    " leave less than 2 elements per unit for a grid of " << extents[0] << "×" <<
+                    extents[1] << "×" << extents[2] << ", use the balanced arrangement" << endl;
+            }
+        }
+
+    } else if ( Decomposition::AUTO == decomposition.mode ) {
+
+        /* start with the balanced one, such that it wins ties */
+        std::array< size_t, 3 > best= {{ balanced.num_units(0), balanced.num_units(1), balanced.num_units(2) }};
+        double bestcost= valid_units( extents, best ) ? halo_cost( extents, best, decomposition ) : -1.0;
+
+        for ( size_t pz= 1; pz <= units; ++pz ) {
+            if ( 0 != units % pz ) continue;
+            for ( size_t py= 1; py <= units/pz; ++py ) {
+                if ( 0 != ( units/pz ) % py ) continue;
+
+                std::array< size_t, 3 > p= {{ pz, py, units/pz/py }};
+                if ( ! valid_units( extents, p ) ) continue;
+
+                double cost= halo_cost( extents, p, decomposition );
+                if ( bestcost < 0.0 || cost < bestcost ) {
+                    best= p;
+                    bestcost= cost;
+                }
+            }
+        }
+
+        return TeamSpecT( best[0], best[1], best[2] );
+    }
+
+    return balanced;
+}
+
+
+/* block size at the last of the levels with extents n of one dimension with p units,
+such that every unit has one block of at least 2 elements on every level and the
+block size doubles with every coarsening towards the finer levels. 0 if there is none. */
+static size_t coarsest_block( const std::vector<size_t>& n, size_t p ) {
+
+    size_t lo= 2;
+    size_t hi= std::numeric_limits<size_t>::max();
+    size_t scale= 1;
+    for ( size_t l= n.size(); l-- > 0; ) {
+
+        if ( n[l] < 2 ) return 0;
+        if ( l+1 < n.size() && n[l] != n[l+1] ) scale *= 2;
+
+        /* p blocks cover the level and the last one has at least 2 elements */
+        lo= std::max( lo, ( n[l] + p*scale - 1 ) / ( p*scale ) );
+        if ( 1 < p ) hi= std::min( hi, ( n[l] - 2 ) / ( (p-1)*scale ) );
+    }
+    return ( lo <= hi ) ? lo : 0;
+}
+
+
+/* block size on the first of the levels n, from coarsest_block() doubled with every
+coarsening. 0 if there is none. */
+static size_t finest_block( const std::vector<size_t>& n, size_t p ) {
+
+    size_t block= coarsest_block( n, p );
+    for ( size_t l= 0; l+1 < n.size(); ++l ) {
+        if ( n[l] != n[l+1] ) block *= 2;
+    }
+    return block;
+}
+
+
+/* Plan the levels of one team, starting with extents and grid spacing h, with at most
+maxlevels levels (0 for no limit).
+
+Every dimension with n inner points is coarsened to n/2, rounded down. For odd n the
+coarse points are the odd fine points and the boundaries match. For even n the coarse
+points are the same but the upper coarse boundary lies one fine spacing outside of the
+domain, where the correction is 0 anyway. In mirrored dimensions n needs to be even, such
+that the center planes match. A dimension is not coarsened (semi-coarsening) if that
+would leave a unit with fewer than 2 elements or break the alignment of the blocks,
+and with semicoarsening also if its grid spacing is at least twice the smallest one,
+i.e., the coupling in this direction is weak. The hierarchy ends when no dimension can
+be coarsened anymore.
+
+With balance > 0, a dimension is not coarsened either if the aligned blocks would make the
+largest block on the first level more than 1+balance times the even split ceil(n/p). With
+the regular block patterns of DASH, no distribution gets below ceil(n/p) for the largest
+block, but the alignment to many coarse levels may need more, e.g. 40 instead of 34 for
+100 points on 3 units. Then the dimension is rather coarsened less.
+
+scaledown() and scaleup() work on the local blocks only, therefore the blocks of a coarse
+level need to start at half the global coordinates of the fine blocks. The block sizes
+are chosen from the last level upwards and doubled with every coarsening, see
+coarsest_block(). For the default extents 2^l -1 this is the same as BLOCKED. */
+std::vector<LevelPlan> plan_levels( const std::array< size_t, 3 >& extents, std::array< double, 3 > h,
+        const std::array< bool, 3 >& mirror, const TeamSpecT& teamspec, size_t maxlevels, bool semicoarsening,
+        double balance ) {
+
+    std::array< std::vector<size_t>, 3 > n;
+    for ( uint32_t d= 0; d < 3; ++d ) n[d].push_back( extents[d] );
+
+    while ( 0 == maxlevels || n[0].size() < maxlevels ) {
+
+        double hmin= std::min( h[0], std::min( h[1], h[2] ) );
+        bool coarsened= false;
+
+        for ( uint32_t d= 0; d < 3; ++d ) {
+
+            size_t fine= n[d].back();
+            n[d].push_back( fine );
+
+            if ( semicoarsening && h[d] >= 2.0*hmin ) continue;
+            if ( mirror[d] && 1 == fine % 2 ) continue;
+
+            size_t p= teamspec.num_units(d);
+            n[d].back()= fine/2;
+            size_t block= finest_block( n[d], p );
+            if ( 0 == block || ( 0.0 < balance && block > ( 1.0 + balance ) * ( ( n[d][0] + p - 1 ) / p ) ) ) {
+                n[d].back()= fine;
+                continue;
+            }
+            h[d] *= 2.0;
+            coarsened= true;
+        }
+
+        if ( ! coarsened ) {
+            for ( uint32_t d= 0; d < 3; ++d ) n[d].pop_back();
+            break;
+        }
+    }
+
+    std::vector<LevelPlan> plan( n[0].size() );
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        size_t p= teamspec.num_units(d);
+        size_t block= coarsest_block( n[d], p );
+        if ( 0 == block ) block= ( n[d][0] + p - 1 ) / p; /* single level that does not fit, as BLOCKED */
+
+        for ( size_t l= plan.size(); l-- > 0; ) {
+
+            if ( l+1 < plan.size() && n[d][l] != n[d][l+1] ) block *= 2;
+            plan[l].extents[d]= n[d][l];
+            plan[l].blocks[d]= block;
+        }
+    }
+
+    return plan;
+}
+
+
+void initgrid( Level& level ) {
+
+    /* not strictly necessary but it also avoids NAN values */
+    dash::fill( level.src_grid->begin(), level.src_grid->end(), ValueT( 0.0 ) );
+    dash::fill( level.dst_grid->begin(), level.dst_grid->end(), ValueT( 0.0 ) );
+    dash::fill( level.rhs_grid->begin(), level.rhs_grid->end(), ValueT( 0.0 ) );
+
+    level.src_grid->barrier();
+}
+
+
+/* apply boundary value settings, where the top and bottom planes have a
+hot circle in the middle and everything else is cold */
+void initboundary( Level& level ) {
+
+    using index_t = dash::default_index_t;
+
+    MINIMON_REGION( region_boundary, "setup_boundary" );
+
+    // setup_boundary
+    minimon.start( region_boundary );
+
+    /* the full grid extents, the faces are computed for global coordinates of the
+    stored part only, which are the same in the full grid */
+    double gh= level.full_extent(1);
+    double gw= level.full_extent(2);
+
+    /* This way of setting boundaries uses subsampling on the top and bottom
+    planes to determine the border values. This is another logical way that
+    may be convenient sometimes. It guarantees that the boundary values on all
+    the levels match.
+    All other sides are constant at 0.0 degrees. The top an bottom circles are
+    hot with 10.0 degrees.
+    In batch mode, every right hand side gets its own circle radius, the last one
+    is the original setting.
+    Both planes get the same values, so they are computed once per element of the
+    local part of the face here instead of once per halo element and halo. */
+
+    auto sample= [gh,gw]( index_t y, index_t x ) {
+
+        ValueT ret;
+
+        for ( size_t k= 0; k < batch_size; ++k ) {
+
+            /* radius differs on top and bottom plane */
+            //double r= ( -1 == z ) ? 0.4 : 0.3;
+            double r= 0.4 * ( k + 1 ) / batch_size;
+            double r2= r*r;
+
+            double lowvalue= 2.0;
+            double highvalue= 9.0;
+
+            double midx= 0.5;
+            double midy= 0.5;
+
+            /* At entry (x/gw,y/gh) we sample the
+            rectangle [ x/gw,(x+1)/gw ) x [ y/gw, (y+1)/gh ) with m² points. */
+            int32_t m= 3;
+
+            double sum= 0.0;
+            double weight= 0.0;
+
+            for ( double iy= -m+1; iy < m; iy++ ) {
+                for ( double ix= -m+1; ix < m; ix++ ) {
+
+                    double sx= (x+ix/m)/(gw-1);
+                    double sy= (y+iy/m)/(gh-1);
+
+                    double d2= (sx-midx)*(sx-midx) + (sy-midy)*(sy-midy);
+                    sum += ( d2 <= r2 ) ? highvalue : lowvalue;
+                    weight += 1.0;
+                }
+            }
+            lane( ret, k ) = sum / weight;
+        }
+
+        return ret;
+    };
+
+    /* for simplicity make every side uniform */
+    Boundary& b= level.boundary;
+    b= Boundary();
+    b.side= 1.0;
+    b.ztop= level.full_extent(0);
+
+    /* only units with a block at the bottom or top need the face, and only their part */
+    const auto& ext= level.src_grid->local.extents();
+    const auto& corner= level.src_grid->pattern().global( {0,0,0} );
+    bool bottom= ( 0 == corner[0] );
+    bool top= ( (index_t) ( corner[0] + ext[0] ) == b.ztop );
+
+    if ( bottom || top ) {
+
+        b.y0= corner[1];
+        b.x0= corner[2];
+        b.ny= ext[1] + 2;
+        b.nx= ext[2] + 2;
+        std::vector<ValueT> face( b.ny * b.nx );
+        for ( index_t y= b.y0-1; y < b.y0+b.ny-1; ++y ) {
+            for ( index_t x= b.x0-1; x < b.x0+b.nx-1; ++x ) {
+                face[ b.pos( y, x ) ]= sample( y, x );
+            }
+        }
+        if ( bottom ) b.bottom= face;
+        if ( top ) b.top= std::move( face );
+    }
+
+    setboundary( level );
+
+    minimon.stop( region_boundary, level.src_grid->team().size(), level.src_grid->size() );
+}
+
+
+/* sets all boundary values to 0, that is what is neede on the coarser grids */
+void initboundary_zero( Level& level ) {
+
+    MINIMON_REGION( region_boundary, "setup_boundary" );
+
+    // setup_boundary
+    minimon.start( region_boundary );
+
+    level.boundary= Boundary();
+    setboundary( level );
+
+    minimon.stop( region_boundary, level.src_grid->team().size(), level.src_grid->size() );
+}
+
+
+/* set the boundary elements of both halos from level.boundary */
+void setboundary( Level& level ) {
+
+    const Boundary& b= level.boundary;
+
+    if ( b.constant() ) {
+
+        /* fast path without any lookup */
+        ValueT side= b.side;
+        auto lambda= [side]( const auto& ) { return side; };
+        level.src_halo->set_custom_halos( lambda );
+        level.dst_halo->set_custom_halos( lambda );
+
+    } else {
+
+        auto lambda= [&b]( const auto& coords ) { return b.at( coords ); };
+        level.src_halo->set_custom_halos( lambda );
+        level.dst_halo->set_custom_halos( lambda );
+    }
+}
+
+
+PackedHalo::PackedHalo( MatrixT& grid, HaloT& halo ) : _grid( grid ) {
+
+    using index_t = dash::default_index_t;
+    /* [lo,hi) of global coordinates per dimension */
+    using box_t = std::array< std::array< index_t, 2 >, 3 >;
+
+    const auto& pattern= grid.pattern();
+    dash::Team& team= grid.team();
+    dash::team_unit_t me( team.myid() );
+
+    auto block= [&pattern]( dash::team_unit_t u ) {
+
+        const auto& corner= pattern.global( u, {0,0,0} );
+        const auto& ext= pattern.local_extents( u );
+        box_t b;
+        for ( uint32_t d= 0; d < 3; ++d ) {
+            b[d]= {{ (index_t) corner[d], (index_t) ( corner[d] + ext[d] ) }};
+        }
+        return b;
+    };
+
+    /* a intersected with b grown by 1 */
+    auto intersect= []( const box_t& a, const box_t& b ) {
+
+        box_t c;
+        for ( uint32_t d= 0; d < 3; ++d ) {
+            c[d]= {{ std::max( a[d][0], b[d][0]-1 ), std::min( a[d][1], b[d][1]+1 ) }};
+        }
+        return c;
+    };
+
+    auto empty= []( const box_t& b ) {
+
+        return b[0][0] >= b[0][1] || b[1][0] >= b[1][1] || b[2][0] >= b[2][1];
+    };
+
+    /* one of 27 slots for the direction from which the box comes */
+    auto slot= []( const box_t& from, const box_t& to ) {
+
+        size_t s= 0;
+        for ( uint32_t d= 0; d < 3; ++d ) {
+            s= 3*s + ( ( from[d][0] < to[d][0] ) ? 0 : ( from[d][0] == to[d][0] ) ? 1 : 2 );
+        }
+        return s;
+    };
+
+    /* unit 0 has the largest block, see plan_levels(), its largest face bounds every box */
+    const auto& ext0= pattern.local_extents( dash::team_unit_t( 0 ) );
+    size_t slotsize= std::max( ext0[0]*ext0[1], std::max( ext0[0]*ext0[2], ext0[1]*ext0[2] ) );
+    _recv.allocate( team.size() * 27 * slotsize, dash::BLOCKED, team );
+
+    const auto& ext= pattern.local_extents( me );
+    box_t mine= block( me );
+
+    for ( size_t u= 0; u < team.size(); ++u ) {
+
+        dash::team_unit_t unit( u );
+        if ( unit == me ) continue;
+
+        box_t theirs= block( unit );
+
+        /* what the neighbor needs from this unit */
+        box_t out= intersect( mine, theirs );
+        if ( ! empty( out ) ) {
+
+            Neighbor n;
+            n.unit= unit;
+            n.begin= _send_local.size();
+            for ( index_t z= out[0][0]; z < out[0][1]; ++z ) {
+                for ( index_t y= out[1][0]; y < out[1][1]; ++y ) {
+                    for ( index_t x= out[2][0]; x < out[2][1]; ++x ) {
+                        _send_local.push_back( ( ( z-mine[0][0] )*ext[1] + ( y-mine[1][0] ) )*ext[2] + ( x-mine[2][0] ) );
+                    }
+                }
+            }
+            n.end= _send_local.size();
+            n.remote= ( u*27 + slot( mine, theirs ) ) * slotsize;
+            _neighbors.push_back( n );
+        }
+
+        /* what this unit needs from the neighbor, the same box seen from the other side */
+        box_t in= intersect( theirs, mine );
+        if ( ! empty( in ) ) {
+
+            size_t i= slot( theirs, mine ) * slotsize;
+            for ( index_t z= in[0][0]; z < in[0][1]; ++z ) {
+                for ( index_t y= in[1][0]; y < in[1][1]; ++y ) {
+                    for ( index_t x= in[2][0]; x < in[2][1]; ++x ) {
+
+                        ValueT* halo_element= halo.halo_element_at_global( {{ z, y, x }} );
+                        assert( nullptr != halo_element );
+                        _recv_local.push_back( i++ );
+                        _recv_halo.push_back( halo_element );
+                    }
+                }
+            }
+        }
+    }
+
+    _send.resize( _send_local.size() );
+    _puts.reserve( _neighbors.size() );
+}
+
+
+void PackedHalo::update_async() {
+
+    const ValueT* local= _grid.lbegin();
+    for ( size_t i= 0; i < _send.size(); ++i ) {
+        _send[i]= local[ _send_local[i] ];
+    }
+
+    for ( const Neighbor& n : _neighbors ) {
+        _puts.push_back( dash::copy_async( _send.data() + n.begin, _send.data() + n.end,
+            _recv.begin() + n.remote ) );
+    }
+}
+
+
+void PackedHalo::wait() {
+
+    for ( auto& p : _puts ) p.wait();
+    _puts.clear();
+
+    /* the puts of all neighbors into this unit are done */
+    _recv.barrier();
+
+    const ValueT* buf= _recv.lbegin();
+    for ( size_t i= 0; i < _recv_halo.size(); ++i ) {
+        *_recv_halo[i]= buf[ _recv_local[i] ];
+    }
+}
+
+
+void Progress::start( std::chrono::microseconds interval, uint32_t sample ) {
+
+    if ( enabled() ) return;
+
+    _interval= interval;
+    _sample= sample;
+    _running= true;
+    _thread= std::thread( &Progress::run, this );
+}
+
+
+void Progress::stop() {
+
+    if ( ! enabled() ) return;
+
+    _running= false;
+    _thread.join();
+}
+
+
+bool Progress::begin() {
+
+    if ( ! enabled() || ( 0 < _sample && 0 == ++_sweeps % _sample ) ) return false;
+
+    _polls.store( 0, std::memory_order_relaxed );
+    _active.store( true, std::memory_order_release );
+    return true;
+}
+
+
+uint64_t Progress::end() {
+
+    _active.store( false, std::memory_order_release );
+    return _polls.load( std::memory_order_relaxed );
+}
+
+
+void Progress::run() {
+
+    while ( _running.load( std::memory_order_acquire ) ) {
+
+        if ( _active.load( std::memory_order_acquire ) ) {
+
+            /* DART has no call to drive the progress of its RMA windows, so this is a
+            heuristic: most MPI implementations run their whole progress engine in any
+            MPI call, but none guarantees that this moves the one-sided transfers */
+            int flag= 0;
+            MPI_Iprobe( MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE );
+            _polls.fetch_add( 1, std::memory_order_relaxed );
+        }
+
+        if ( 0 < _interval.count() ) {
+            std::this_thread::sleep_for( _interval );
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+double Progress::hidden() {
+
+    const auto assisted= minimon.get_slots( "smoothen_wait_assisted" );
+    const auto unassisted= minimon.get_slots( "smoothen_wait_unassisted" );
+
+    /* the assisted wait against the unassisted wait the same sweeps would have had */
+    double sum_assisted= 0.0;
+    double sum_unassisted= 0.0;
+    for ( const auto& a : assisted ) {
+
+        const auto u= unassisted.find( a.first );
+        if ( unassisted.end() == u || 0.0 == a.second.second || 0.0 == u->second.second ) continue;
+
+        double mean_assisted= a.second.first / a.second.second;
+        double mean_unassisted= u->second.first / u->second.second;
+        if ( 0.0 < mean_unassisted ) {
+            minimon.record( "progress_hidden", a.first.first, a.first.second, 1.0 - mean_assisted / mean_unassisted );
+        }
+
+        sum_assisted += a.second.first;
+        sum_unassisted += a.second.second * mean_unassisted;
+    }
+
+    return ( 0.0 < sum_unassisted ) ? 1.0 - sum_assisted / sum_unassisted : 0.0;
+}
+
+
+/* bytes of the largest face of a block, unit 0 has the largest block */
+size_t largest_face_bytes( Level& level ) {
+
+    const auto& ext= level.src_grid->pattern().local_extents( dash::team_unit_t( 0 ) );
+    return std::max( ext[0]*ext[1], std::max( ext[0]*ext[2], ext[1]*ext[2] ) ) * sizeof(ValueT);
+}
+
+
+/* In symmetry mode the halo plane behind the center plane c of a mirrored dimension is
+the mirror image of the plane c-1. Refresh it in the src halo from the local data.
+This is only done by the units at the upper end of a mirrored dimension and needs no
+communication. Call it after every halo update of the src halo that is going to be read.
+Only the faces are refreshed, the 7-point stencils never read edges or corners. */
+void update_mirror_halos( Level& level ) {
+
+    using index_t = dash::default_index_t;
+
+    MatrixT& grid= *level.src_grid;
+    const auto& ext= grid.local.extents();
+    const auto& corner= grid.pattern().global( {0,0,0} );
+
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        if ( ! level.mirror[d] || corner[d] + ext[d] != grid.extent(d) ) continue;
+
+        assert( 2 <= ext[d] );
+
+        uint32_t d1= (d+1)%3;
+        uint32_t d2= (d+2)%3;
+
+        std::array< index_t, 3 > gcoords;
+        std::array< index_t, 3 > lcoords;
+        gcoords[d]= grid.extent(d);
+        lcoords[d]= ext[d]-2;
+
+        for ( index_t i= 0; i < (index_t) ext[d1]; ++i ) {
+            for ( index_t j= 0; j < (index_t) ext[d2]; ++j ) {
+
+                gcoords[d1]= corner[d1] + i;
+                gcoords[d2]= corner[d2] + j;
+                lcoords[d1]= i;
+                lcoords[d2]= j;
+
+                ValueT* halo_element= level.src_halo->halo_element_at_global( gcoords );
+                assert( nullptr != halo_element );
+                *halo_element= grid.local[lcoords[0]][lcoords[1]][lcoords[2]];
+            }
+        }
+    }
+}
+
+
+/* value of the full grid at global coordinates z,y,x, in symmetry mode this reconstructs
+the mirrored part from the stored part. Global access, so this is slow. */
+ValueT full_value_at( Level& level, size_t z, size_t y, size_t x ) {
+
+    std::array< size_t, 3 > c= {{ z, y, x }};
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        size_t n= level.src_grid->extent(d);
+        if ( level.mirror[d] && c[d] >= n ) c[d]= 2*(n-1) - c[d];
+    }
+
+    return (*level.src_grid)[c[0]][c[1]][c[2]];
+}
+
+
+/* maximum of v over all units of the team, collective, a single MPI_Allreduce on the
+communicator of the team without any allocation */
+double team_max( dash::Team& team, double v ) {
+
+    double res= v;
+    dart_allreduce( &v, &res, 1, DART_TYPE_DOUBLE, DART_OP_MAX, team.dart_id() );
+    return res;
+}
+
+
+/* Report the load imbalance of a level, the largest number of local elements of a
+unit over the mean. Every smoothing sweep ends with the Allreduce of the residual,
+so the whole team waits for the unit with the largest block. Printed per level and
+recorded as level_imbalance_<level number> in MiniMon with the team size as
+parameter like all other regions. Collective over the team of the level. */
+double report_imbalance( Level& level, size_t index ) {
+
+    MatrixT& grid= *level.src_grid;
+    dash::Team& team= grid.team();
+
+    double local= grid.local_size();
+    double lmax= team_max( team, local );
+    double lmin= -team_max( team, -local );
+    double mean= (double) grid.size() / team.size();
+    double imbalance= lmax / mean;
+
+    minimon.record( "level_imbalance_" + std::to_string( index ), team.size(), grid.size(), imbalance );
+
+    /* replicated levels only once */
+    if ( 0 == team.myid() && 0 == team.position() ) {
+        cout << "level " << index << " of " <<
+            grid.extent(0) << "×" << grid.extent(1) << "×" << grid.extent(2) <<
+            " with " << team.size() << " units: local elements max " << lmax <<
+            " mean " << mean << " min " << lmin << " ⇒ imbalance " << imbalance << endl;
+    }
+
+    return imbalance;
+}
+
+
+/* Check the grid for 3d mirror symmetry at the center planes. This should hold for
+appropriate boundary conditions and a correct solver.
+
+Every unit checks its local block against the mirror images in z, y, and x, one
+dimension after the other. The mirror partners are the units with the mirrored range
+of the local block in that dimension. Only the part of their block that is compared
+is fetched, directly from the grid with asynchronous bulk copies, one per run of
+elements that is contiguous in the global order of the pattern, i.e., one per
+partner if the blocks match. The maximum deviation is reduced over the team. In
+symmetry mode the mirrored dimensions are symmetric by construction and skipped.
+Collective, all units return the same result. */
+bool check_symmetry( Level& level, double eps ) {
+
+    using index_t = dash::default_index_t;
+
+    MINIMON_REGION( region_check, "check_symmetry" );
+
+    // check_symmetry
+    minimon.start( region_check );
+
+    MatrixT& grid= *level.src_grid;
+    dash::Team& team= grid.team();
+    const auto& pattern= grid.pattern();
+
+    const auto& corner= pattern.global( {0,0,0} );
+    const auto& ext= pattern.local_extents();
+    std::array< index_t, 3 > n= {{ (index_t) grid.extent(0), (index_t) grid.extent(1), (index_t) grid.extent(2) }};
+
+    /* all units are done writing the grid */
+    grid.barrier();
+
+    double deviation= 0.0;
+    std::vector<ValueT> mirrored;
+
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        if ( level.mirror[d] ) continue;
+
+        for ( size_t u= 0; u < team.size(); ++u ) {
+
+            const auto& c= pattern.global( dash::team_unit_t( u ), {0,0,0} );
+            const auto& e= pattern.local_extents( dash::team_unit_t( u ) );
+
+            /* [lo,hi) of global coordinates of the compared part of the block of u,
+            the mirror image of the local block */
+            std::array< index_t, 3 > lo, hi;
+            bool partner= true;
+            for ( uint32_t o= 0; o < 3; ++o ) {
+
+                if ( o != d && c[o] != corner[o] ) partner= false;
+                lo[o]= corner[o];
+                hi[o]= corner[o] + ext[o];
+            }
+            lo[d]= std::max( (index_t) c[d], n[d] - (index_t) ( corner[d] + ext[d] ) );
+            hi[d]= std::min( (index_t) ( c[d] + e[d] ), n[d] - (index_t) corner[d] );
+            if ( ! partner || lo[d] >= hi[d] ) continue;
+
+            size_t width= hi[2] - lo[2];
+            mirrored.resize( ( hi[0] - lo[0] ) * ( hi[1] - lo[1] ) * width );
+
+            /* rows in the order of the buffer, merged while they are contiguous */
+            std::vector< dash::Future<ValueT*> > copies;
+            index_t begin= -1, end= -1;
+            size_t offset= 0, pos= 0;
+            for ( index_t z= lo[0]; z < hi[0]; ++z ) {
+                for ( index_t y= lo[1]; y < hi[1]; ++y ) {
+
+                    index_t g= pattern.global_at( {{ z, y, lo[2] }} );
+                    if ( g != end ) {
+                        if ( 0 <= begin ) {
+                            copies.push_back( dash::copy_async( grid.begin() + begin, grid.begin() + end, mirrored.data() + offset ) );
+                        }
+                        begin= g;
+                        offset= pos;
+                    }
+                    end= g + width;
+                    pos += width;
+                }
+            }
+            copies.push_back( dash::copy_async( grid.begin() + begin, grid.begin() + end, mirrored.data() + offset ) );
+
+            for ( auto& f : copies ) f.wait();
+
+            const ValueT* m= mirrored.data();
+            for ( index_t z= lo[0]; z < hi[0]; ++z ) {
+                for ( index_t y= lo[1]; y < hi[1]; ++y ) {
+                    for ( index_t x= lo[2]; x < hi[2]; ++x, ++m ) {
+
+                        /* local coordinates of the mirror image in d */
+                        std::array< index_t, 3 > l= {{ z - corner[0], y - corner[1], x - corner[2] }};
+                        l[d]= n[d] - 1 - ( d == 0 ? z : d == 1 ? y : x ) - corner[d];
+                        deviation= std::max( deviation, maxabs( grid.local[l[0]][l[1]][l[2]] - *m ) );
+                    }
+                }
+            }
+        }
+    }
+
+    deviation= team_max( team, deviation );
+
+    minimon.stop( region_check, team.size(), grid.local_size() );
+
+    if ( 0 == team.myid() ) {
+        cout << "symmetry check: max deviation " << deviation << endl;
+    }
+
+    return deviation <= eps;
+}
+
+
+void scaledownboundary( Level& fine, Level& coarse ) {
+
+    assert( coarse.src_grid->extent(2)*2 == fine.src_grid->extent(2) );
+    assert( coarse.src_grid->extent(1)*2 == fine.src_grid->extent(1) );
+    assert( coarse.src_grid->extent(0)*2 == fine.src_grid->extent(0) );
+
+    size_t dmax= coarse.src_grid->extent(0);
+    size_t hmax= coarse.src_grid->extent(1);
+    //size_t wmax= coarse.src_grid->extent(2);
+
+    auto finehalo= fine.src_halo;
+
+    auto lambda= [&finehalo,&dmax,&hmax]( const auto& coord ) {
+
+        auto coordf= coord;
+        for( auto& c : coordf ) {
+            if ( c > 0 ) c *= 2;
+        }
+
+        if ( -1 == coord[0] || dmax == coord[0] ) {
+
+            /* z plane */
+            return 0.25 * (
+                *finehalo->halo_element_at_global( { coordf[0], coordf[1]+0, coordf[2]+0 } ) +
+                *finehalo->halo_element_at_global( { coordf[0], coordf[1]+0, coordf[2]+1 } ) +
+                *finehalo->halo_element_at_global( { coordf[0], coordf[1]+1, coordf[2]+0 } ) +
+                *finehalo->halo_element_at_global( { coordf[0], coordf[1]+1, coordf[2]+1 } ) );
+
+        } else if ( -1 == coord[1] || hmax == coord[1] ) {
+
+            /* y plane */
+            return 0.25 * (
+                *finehalo->halo_element_at_global( { coordf[0]+0, coordf[1], coordf[2]+0 } ) +
+                *finehalo->halo_element_at_global( { coordf[0]+0, coordf[1], coordf[2]+1 } ) +
+                *finehalo->halo_element_at_global( { coordf[0]+1, coordf[1], coordf[2]+0 } ) +
+                *finehalo->halo_element_at_global( { coordf[0]+1, coordf[1], coordf[2]+1 } ) );
+
+        } else /* if ( -1 == coord[2] || wmax == coord[2] ) */ {
+
+            /* x plane */
+            return 0.25 * (
+                *finehalo->halo_element_at_global( { coordf[0]+0, coordf[1]+0, coordf[2] } ) +
+                *finehalo->halo_element_at_global( { coordf[0]+0, coordf[1]+1, coordf[2] } ) +
+                *finehalo->halo_element_at_global( { coordf[0]+1, coordf[1]+0, coordf[2] } ) +
+                *finehalo->halo_element_at_global( { coordf[0]+1, coordf[1]+1, coordf[2] } ) );
+
+        }
+    };
+
+    coarse.src_halo->set_custom_halos( lambda );
+    coarse.dst_halo->set_custom_halos( lambda );
+}
+
+/* per dimension the factor 2 between the fine and the coarse level, or 1 for a dimension
+that is not coarsened, see plan_levels(). Coarse index c is at fine index s*(c+1)-1. */
+static std::array< std::make_signed<size_t>::type, 3 > coarsening( const Level& fine, const Level& coarse ) {
+
+    std::array< std::make_signed<size_t>::type, 3 > s;
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        size_t nf= fine.src_grid->extent(d);
+        size_t nc= coarse.src_grid->extent(d);
+        s[d]= ( nc == nf ) ? 1 : 2;
+
+        assert( nc == nf || nc == nf/2 );
+
+        /* in mirrored dimensions the center plane of the coarse grid maps to the
+        center plane of the fine grid, which are the last planes there */
+        assert( nc == nf || ! fine.mirror[d] || 0 == nf % 2 );
+    }
+    return s;
+}
+
+
+/* the interpolation weights of stencil_spec for a coarse level with the factors s from
+coarsening(), in a dimension that is not coarsened the neighbors get nothing */
+static StencilSpecT prolongation_spec( const std::array< std::make_signed<size_t>::type, 3 >& s ) {
+
+    double wz= ( 2 == s[0] ) ? 0.5 : 0.0;
+    double wy= ( 2 == s[1] ) ? 0.5 : 0.0;
+    double wx= ( 2 == s[2] ) ? 0.5 : 0.0;
+
+    return StencilSpecT(
+        StencilT(wz, -1, 0, 0), StencilT(wz, 1, 0, 0),
+        StencilT(wy,  0,-1, 0), StencilT(wy, 0, 1, 0),
+        StencilT(wx,  0, 0,-1), StencilT(wx, 0, 0, 1),
+
+        StencilT(wz*wy, -1,-1, 0), StencilT(wz*wy, 1, 1, 0),
+        StencilT(wz*wx, -1, 0,-1), StencilT(wz*wx, 1, 0, 1),
+        StencilT(wy*wx,  0,-1,-1), StencilT(wy*wx, 0, 1, 1),
+        StencilT(wz*wy, -1, 1, 0), StencilT(wz*wy, 1,-1, 0),
+        StencilT(wz*wx, -1, 0, 1), StencilT(wz*wx, 1, 0,-1),
+        StencilT(wy*wx,  0,-1, 1), StencilT(wy*wx, 0, 1,-1),
+
+        StencilT(wz*wy*wx, -1,-1,-1), StencilT(wz*wy*wx, 1,-1,-1),
+        StencilT(wz*wy*wx, -1,-1, 1), StencilT(wz*wy*wx, 1,-1, 1),
+        StencilT(wz*wy*wx, -1, 1,-1), StencilT(wz*wy*wx, 1, 1,-1),
+        StencilT(wz*wy*wx, -1, 1, 1), StencilT(wz*wy*wx, 1, 1, 1));
+}
+
+
+void scaledown( Level& fine, Level& coarse ) {
+    using signed_size_t = typename std::make_signed<size_t>::type;
+
+    TraceLevel trace( fine );
+
+    auto& finegrid= *fine.src_grid;
+    auto& fine_rhs_grid= *fine.rhs_grid;
+    auto& coarsegrid= *coarse.src_grid;
+    auto& coarse_rhs_grid= *coarse.rhs_grid;
+
+    // stencil points for scale down with coefficients
+    dash::halo::StencilSpec<StencilT,6> stencil_spec(
+      StencilT(-fine.az, -1, 0, 0), StencilT(-fine.az, 1, 0, 0),
+      StencilT(-fine.ay,  0,-1, 0), StencilT(-fine.ay, 0, 1, 0),
+      StencilT(-fine.ax,  0, 0,-1), StencilT(-fine.ax, 0, 0, 1)
+    );
+
+    MINIMON_REGION( region_scaledown, "scaledown" );
+
+    // scaledown
+    minimon.start( region_scaledown );
+
+    const auto s= coarsening( fine, coarse );
+
+    const auto& extentc= coarsegrid.local.extents();
+    const auto& cornerc= coarsegrid.pattern().global( {0,0,0} );
+    const auto& extentf= finegrid.local.extents();
+    const auto& cornerf= finegrid.pattern().global( {0,0,0} );
+
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        assert( cornerc[d] * s[d] == cornerf[d] );
+        assert( extentc[d] * s[d] == extentf[d] || ( 2 == s[d] && extentc[d] * 2 +1 == extentf[d] ) );
+    }
+
+    /* Here we  $ r= f - Au $ on the fine grid and 'straigth injection' to the
+    rhs of the coarser grid in one. Therefore, we don't need a halo of the fine
+    grid, because the stencil neighbor points on the fine grid are always there
+    for a coarse grid point.
+    According to the text book (Introduction to Algebraic Multigrid -- Course notes
+    of an algebraic multigrid course at univertisty of Heidelberg in Wintersemester
+    1998/99, Version 1.1 by Christian Wagner http://www.mgnet.org/mgnet/papers/Wagner/amgV11.pdf)
+    there should by an extra factor 1/2^3 for the coarse value. With the matrix of the
+    finest grid on all levels, an extra factor 4.0 works much better. This is the same as
+    the matrix of the actual coarse grid spacing, see Level, without extra factor, which
+    also holds for semi-coarsening. */
+
+    /* 1) start async halo exchange for fine grid*/
+    fine.update_halo_async();
+
+    // iterates over all inner elements and calculates value for coarse rhs grid
+    auto stencil_op_fine = fine.src_halo->stencil_operator(stencil_spec);
+    for ( signed_size_t z= 1; z < extentc[0] - 1 ; z++ ) {
+      for ( signed_size_t y= 1; y < extentc[1] - 1 ; y++ ) {
+        for ( signed_size_t x= 1; x < extentc[2] - 1 ; x++ ) {
+          coarse_rhs_grid.local[z][y][x] =
+              fine.ff * fine_rhs_grid.local[s[0]*(z+1)-1][s[1]*(y+1)-1][s[2]*(x+1)-1] +
+              stencil_op_fine.inner.get_value_at({s[0]*(z+1)-1,s[1]*(y+1)-1,s[2]*(x+1)-1}, -fine.acenter);
+        }
+      }
+    }
+
+    /* 3) set coarse grid to 0.0 */
+    dash::fill( coarsegrid.begin(), coarsegrid.end(), ValueT( 0.0 ) );
+
+    /* 4) wait for async halo exchange. Technically, we need only the back halos in every
+    dimension and only for the front unit per dimension. However, we do the halo update
+    collectvely to keep it managable. */
+
+    fine.wait_halo();
+    update_mirror_halos( fine );
+
+    auto& stencil_op_coarse = *coarse.src_op;
+    auto* coarse_rhs_begin = coarse_rhs_grid.lbegin();
+    // update all boundary elements for coarse rhs grid
+    // coarse grid halo wrapper used to get coordinates for coarse rhs grid
+    // elements
+    auto bend = stencil_op_coarse.boundary.end();
+    for( auto it = stencil_op_coarse.boundary.begin(); it != bend; ++it ) {
+      const auto& coords = it.coords();
+      // coarse coords to fine grid coords
+      decltype(coords) coords_fine = {s[0]*(coords[0]+1) - 1, s[1]*(coords[1]+1) - 1, s[2]*(coords[2]+1) - 1};
+      // updates value for coarse rhs grid
+      coarse_rhs_begin[it.lpos()] =
+        fine.ff * fine_rhs_grid.local[coords_fine[0]][coords_fine[1]][coords_fine[2]] +
+        // default operation std::plus used for stencil point and center values
+        stencil_op_fine.boundary.get_value_at(coords_fine, -fine.acenter);
+    }
+
+    /* the bytes are the compulsory memory traffic: the fine values are read once, of
+    the fine rhs only the rows with coarse elements, and the coarse rhs value and the
+    coarse value are written once and read once for the write-allocate */
+    minimon.stop( region_scaledown, finegrid.team().size(), finegrid.local_size(),
+        /* flops */ 16*coarsegrid.local_size()*batch_size,
+        /* bytes read */ ( finegrid.local_size() + finegrid.local_size()/(s[0]*s[1]) + 2*coarsegrid.local_size() )*sizeof(ValueT),
+        /* bytes written */ 2*coarsegrid.local_size()*sizeof(ValueT) );
+}
+
+
+/* Build the prolongation operators of fine for scaleup() from coarse once if coarse is
+semi-coarsened, such that the cycle does not construct any operator. With full
+coarsening, scaleup() uses the operators of fine itself, and without any coarsening,
+e.g., for the transfer levels, there is no scaleup(). */
+void setup_prolongation( Level& coarse, Level& fine ) {
+
+    const auto s= coarsening( fine, coarse );
+    bool full= ( 2 == s[0] && 2 == s[1] && 2 == s[2] );
+    bool none= ( 1 == s[0] && 1 == s[1] && 1 == s[2] );
+    if ( ! full && ! none && nullptr == fine.src_prolong ) fine.enable_prolongation( prolongation_spec( s ) );
+}
+
+
+/* this version uses a correct prolongation from the coarser grid of (2^n)^3 to (2^(n+1))^3
+elements. Note that it is 2^n elements per dimension instead of 2^n -1!
+This version loops over the coarse grid. Dimensions that are not coarsened are copied,
+see coarsening() and prolongation_spec(). */
+//void scaleup_loop_coarse( Level& coarse, Level& fine ) {
+void scaleup( Level& coarse, Level& fine ) {
+    using signed_size_t = typename std::make_signed<size_t>::type;
+
+    TraceLevel trace( fine );
+
+    MatrixT& coarsegrid= *coarse.src_grid;
+    MatrixT& finegrid= *fine.src_grid;
+
+    MINIMON_REGION( region_scaleup, "scaleup" );
+
+    // scaleup
+    minimon.start( region_scaleup );
+
+    const auto s= coarsening( fine, coarse );
+
+    const auto& extentc= coarsegrid.pattern().local_extents();
+    const auto& cornerc= coarsegrid.pattern().global( {0,0,0} );
+    const auto& extentf= finegrid.pattern().local_extents();
+    const auto& cornerf= finegrid.pattern().global( {0,0,0} );
+
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        assert( cornerc[d] * s[d] == cornerf[d] );
+        assert( extentc[d] * s[d] == extentf[d] || ( 2 == s[d] && extentc[d] * 2 +1 == extentf[d] ) );
+    }
+
+    /* if last element in coarse grid per dimension has no 2*i+2 element in
+    the local fine grid, then handle it as a separate loop using halo.
+    sub[i] is always 0 or 1 */
+    std::array< size_t, 3 > sub;
+    for ( uint32_t i= 0; i < 3; ++i ) {
+         sub[i]= ( 2 == s[i] && extentc[i] * 2 == extentf[i] ) ? 1 : 0;
+    }
+
+    /* with semi-coarsening, the interpolation weights differ from the ones of the
+    stencil operator of the fine level, the operator is built once per level */
+    bool full= ( 2 == s[0] && 2 == s[1] && 2 == s[2] );
+    if ( ! full && nullptr == fine.src_prolong ) fine.enable_prolongation( prolongation_spec( s ) );
+
+    /* start async halo exchange for coarse grid*/
+    coarse.update_halo_async();
+
+    /* second loop over the coarse grid and add the contributions to the
+    fine grid elements */
+
+    /* this is the iterator-ized version of the code */
+
+    auto& stencil_op_fine = full ? *fine.src_op : *fine.src_prolong;
+    // set inner elements
+    for ( signed_size_t z= 1; z < extentc[0] - 1; z++ ) {
+      for ( signed_size_t y= 1; y < extentc[1] - 1; y++ ) {
+        for ( signed_size_t x= 1; x < extentc[2] - 1; x++ ) {
+          stencil_op_fine.inner.set_values_at({s[0]*(z+1)-1, s[1]*(y+1)-1, s[2]*(x+1)-1},
+          coarsegrid.local[z][y][x], 1.0,std::plus<ValueT>());
+        }
+      }
+    }
+
+    // set values for boundary elements, halo elements are excluded
+    auto bend = coarse.src_op->boundary.end();
+    for (auto it = coarse.src_op->boundary.begin(); it != bend; ++it ) {
+      const auto& coords = it.coords();
+      stencil_op_fine.boundary.set_values_at( {s[0]*(coords[0]+1)-1, s[1]*(coords[1]+1)-1,
+          s[2]*(coords[2]+1)-1}, *it, 1.0, std::plus<ValueT>());
+    }
+
+    /* wait for async halo exchange */
+    coarse.wait_halo();
+
+    /* do the remaining updates with contributions from the coarse halo
+	for 6 planes, 12 edges, and 8 corners */
+
+    const auto& halo_block = coarse.src_halo->halo_block();
+    const auto& view = halo_block.view();
+    const auto& specs = stencil_op_fine.stencil_spec().specs();
+
+    // iterates over all halo regions to find and get all halo regions before
+    // center -> only needed for element update
+    for(const auto& region : halo_block.halo_regions()) {
+
+      // region filter -> custom halo regions and regions behind center are
+      // excluded, as well as regions beside the center in dimensions that are
+      // not coarsened, they only contribute with weight 0
+      if(region.is_custom_region() ||
+         (region.spec()[0] == 2 && sub[0]) ||
+         (region.spec()[1] == 2 && sub[1]) ||
+         (region.spec()[2] == 2 && sub[2]) ||
+         (region.spec()[0] != 1 && s[0] == 1) ||
+         (region.spec()[1] != 1 && s[1] == 1) ||
+         (region.spec()[2] != 1 && s[2] == 1)) {
+        continue;
+      }
+
+      // iterates over all region elements und updates all  elements in fine
+      // grid, except halo elements
+      auto region_end = region.end();
+      for(auto it = region.begin(); it != region_end; ++it) {
+        auto coords = it.gcoords();
+        // pointer to halo element
+        ValueT* halo_element = coarse.src_halo->halo_element_at_global(coords);
+
+        // if halo element == nullptr no halo element exists for the given
+        // coordinates -> continue with next element
+        if(halo_element == nullptr)
+          continue;
+
+        // convert global coordinate to local and fine grid coordinate
+        for(auto d = 0; d < 3; d++) {
+          coords[d] -= view.offset(d); // to local
+          if(coords[d] < 0 )
+            continue;
+
+          coords[d] = s[d] * ( coords[d] + 1 ) - 1; // to fine grid
+        }
+
+        // iterates over all stencil points
+        for(auto i = 0; i < specs.size(); ++i) {
+          // returns pair -> first stencil_point adjusted coords, second check for halo
+          auto coords_stencilp = specs[i].stencil_coords_check_abort(coords,
+              stencil_op_fine.view_local());
+          /*
+           * Checks if stencil point points to a local memory element.
+           * if its points to a halo element continue with next stencil point
+           */
+          if(coords_stencilp.second)
+            continue;
+
+          // set new value for stencil point element
+          auto offset =  stencil_op_fine.get_offset(coords_stencilp.first);
+          finegrid.lbegin()[offset] += specs[i].coefficient() * *halo_element;
+        }
+      }
+    }
+
+    /* how to calculate the number of flops here: for every element there are 2 flop (one add, one mul), 
+    then calculate the number of finegrid points that receive a contribution from a coarse grid point with 
+    coefficient 1.0, 0.5, 0.25, an 0.125 separately. Consider the case where a unit is last in the distributions
+    in any dimension, which is marked with 'sub[.]==1'. In those cases change '(extentc[.]-1)' --> '(extentc[.]-1+sub[.])'
+    Then sum them up and simplify. */
+    auto touched= [&]( uint32_t d ) { return ( 2 == s[d] ) ? 2*extentc[d]-1+sub[d] : extentc[d]; };
+    minimon.stop( region_scaleup, coarsegrid.team().size() /* param */, coarsegrid.local_size() /* elem */,
+        touched(0)*touched(1)*touched(2)*2*batch_size /* flops */,
+        ( coarsegrid.local_size() + finegrid.local_size() )*sizeof(ValueT) /* bytes read */,
+        finegrid.local_size()*sizeof(ValueT) /* bytes written */ );
+}
+
+void transfertofewer( Level& source /* with larger team*/, Level& dest /* with smaller team */ ) {
+
+    TraceLevel trace( source );
+
+    /* should only be called by the smaller team */
+    assert( 0 == dest.src_grid->team().position() );
+
+    cout << "unit " << dash::myid() << " transfertofewer" << endl;
+
+    /* we need to find the coordinates that the local unit needs to receive
+    from several other units that are not in this team */
+
+    /* we can safely assume that the source blocks are copied entirely */
+
+    std::array< long int, 3 > corner= dest.src_grid->pattern().global( {0,0,0} );
+    std::array< long unsigned int, 3 > sizes= dest.src_grid->pattern().local_extents();
+
+    /*
+    cout << "    start coord: " <<
+        corner[0] << ", "  << corner[1] << ", " << corner[2] << endl;
+    cout << "    extents: " <<
+            sizes[0] << ", "  << sizes[1] << ", " << sizes[2] << endl;
+    cout << "    dest local  dist " << dest.src_grid->lend() - dest.src_grid->lbegin() << endl;
+    cout << "    dest global dist " << dest.src_grid->end() - dest.src_grid->begin() << endl;
+    cout << "    src  local  dist " << source.src_grid->lend() - source.src_grid->lbegin() << endl;
+    cout << "    src  global dist " << source.src_grid->end() - source.src_grid->begin() << endl;
+    */
+
+    /* Can I do this any cleverer than loops over the n-1 non-contiguous
+    dimensions and then a dash::copy for the 1 contiguous dimension? */
+
+    /*
+    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
+        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
+            for ( uint32_t x= 0; x < sizes[2]; x++ ) {
+
+                (*dest.src_grid)(z,y,x)= (*source.src_grid)(z,y,x);
+            }
+        }
+    }
+    */
+
+    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
+        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
+
+            size_t offset= ((corner[0]+z)*sizes[1]+y)*sizes[2];
+            std::copy( source.src_grid->begin() + offset, source.src_grid->begin() + offset + sizes[2],
+                &dest.src_grid->local[z][y][0] );
+            std::copy( source.rhs_grid->begin() + offset, source.rhs_grid->begin() + offset + sizes[2],
+                &dest.rhs_grid->local[z][y][0] );
+
+            //dash::copy( start, start + sizes[2], &dest.src_grid->local[z][y][0] );
+            //dash::copy( source.grid.begin()+40, source.grid.begin()+48, buf );
+        }
+    }
+
+}
+
+
+void transfertomore( Level& source /* with smaller team*/, Level& dest /* with larger team */ ) {
+
+    TraceLevel trace( source );
+
+    /* should only be called by the smaller team */
+    assert( 0 == source.src_grid->team().position() );
+
+cout << "unit " << dash::myid() << " transfertomore" << endl;
+
+    /* we need to find the coordinates that the local unit needs to receive
+    from several other units that are not in this team */
+
+    /* we can safely assume that the source blocks are copied entirely */
+
+    std::array< long int, 3 > corner= source.src_grid->pattern().global( {0,0,0} );
+    std::array< long unsigned int, 3 > sizes= source.src_grid->pattern().local_extents();
+
+    /*
+    cout << "    start coord: " <<
+        corner[0] << ", "  << corner[1] << ", " << corner[2] << endl;
+    cout << "    extents: " <<
+            sizes[0] << ", "  << sizes[1] << ", " << sizes[2] << endl;
+    cout << "    dest local  dist " << source.src_grid->lend() - source.src_grid->lbegin() << endl;
+    cout << "    dest global dist " << source.src_grid->end() - source.src_grid->begin() << endl;
+    cout << "    src  local  dist " << dest.src_grid->lend() - dest.src_grid->lbegin() << endl;
+    cout << "    src  global dist " << dest.src_grid->end() - dest.src_grid->begin() << endl;
+    */
+
+    /* stupid but functional version for the case with only one unit in the smaller team, very slow individual accesses */
+    /*
+    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
+        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
+            for ( uint32_t x= 0; x < sizes[2]; x++ ) {
+
+                (*dest.src_grid)(z,y,x)= (*source.src_grid)(z,y,x);
+            }
+        }
+    }
+    */
+    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
+        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
+
+            size_t offset= ((corner[0]+z)*sizes[1]+y)*sizes[2];
+            std::copy( &source.src_grid->local[z][y][0], &source.src_grid->local[z][y][0] + sizes[2],
+                dest.src_grid->begin() + offset );
+            std::copy( &source.rhs_grid->local[z][y][0], &source.rhs_grid->local[z][y][0] + sizes[2],
+                dest.rhs_grid->begin() + offset );
+
+            //dash::copy( start, start + sizes[2], &dest.src_grid->local[z][y][0] );
+            //dash::copy( source.grid.begin()+40, source.grid.begin()+48, buf );
+        }
+    }
+
+    //std::copy( source.src_grid->begin(), source.src_grid->end(), dest.src_grid->begin() );
+}
+
+
+/* Gather the entire distributed level source onto the replicated level dest of every
+unit, i.e., an allgather of the solution and the right hand side. Every unit packs its
+local block into the gather buffer of dest.replica, then fetches the whole buffer with
+one bulk copy and unpacks the blocks of all units at their global coordinates. */
+void replicate( Level& source /* distributed */, Level& dest /* single unit */ ) {
+
+    TraceLevel trace( source );
+
+    MINIMON_REGION( region_replicate, "replicate" );
+
+    // replicate
+    minimon.start( region_replicate );
+
+    MatrixT& grid= *source.src_grid;
+    MatrixT& rhs= *source.rhs_grid;
+    dash::Team& team= grid.team();
+    dash::Array<ValueT>& gather= dest.replica->gather;
+    size_t block= gather.lsize() / 2;
+
+    std::copy( grid.lbegin(), grid.lend(), gather.lbegin() );
+    std::copy( rhs.lbegin(), rhs.lend(), gather.lbegin() + block );
+    gather.barrier();
+
+    std::vector<ValueT> all( gather.size() );
+    dash::copy( gather.begin(), gather.end(), all.data() );
+
+    const auto& pattern= grid.pattern();
+    for ( size_t u= 0; u < team.size(); ++u ) {
+
+        dash::team_unit_t unit( u );
+        const auto& extents= pattern.local_extents( unit );
+        const auto& corner= pattern.global( unit, {0,0,0} );
+        const ValueT* src= all.data() + 2*block*u;
+        const ValueT* srcrhs= src + block;
+
+        for ( size_t z= 0; z < extents[0]; z++ ) {
+            for ( size_t y= 0; y < extents[1]; y++ ) {
+
+                size_t offset= ( z*extents[1] + y ) * extents[2];
+                std::copy( src + offset, src + offset + extents[2],
+                    &dest.src_grid->local[corner[0]+z][corner[1]+y][corner[2]] );
+                std::copy( srcrhs + offset, srcrhs + offset + extents[2],
+                    &dest.rhs_grid->local[corner[0]+z][corner[1]+y][corner[2]] );
+            }
+        }
+    }
+
+    minimon.stop( region_replicate, team.size(), grid.size(), /* flops */ 0,
+        /* bytes read */ gather.size()*sizeof(ValueT), /* bytes written */ 2*grid.size()*sizeof(ValueT) );
+}
+
+
+/* Copy the local block of the distributed level dest back from the solution of the
+replicated level source, which is the same on all units. No communication except
+the barrier before the neighbors read the halos. */
+void unreplicate( Level& source /* single unit */, Level& dest /* distributed */ ) {
+
+    TraceLevel trace( dest );
+
+    const auto& corner= dest.src_grid->pattern().global( {0,0,0} );
+    const auto& extents= dest.src_grid->pattern().local_extents();
+
+    for ( size_t z= 0; z < extents[0]; z++ ) {
+        for ( size_t y= 0; y < extents[1]; y++ ) {
+
+            const ValueT* row= &source.src_grid->local[corner[0]+z][corner[1]+y][corner[2]];
+            std::copy( row, row + extents[2], &dest.src_grid->local[z][y][0] );
+        }
+    }
+
+    dest.src_grid->barrier();
+}
+
+
+/**
+Smoothen the given level from oldgrid+src_halo to newgrid. Call Level::swap() at the end.
+
+The parallel global residual is returned as a return parameter, but only
+if it is not NULL because then the expensive parallel reduction is just avoided.
+*/
+double smoothen( Level& level, Allreduce& res, double coeff ) {
+    SCOREP_USER_FUNC()
+
+    TraceLevel trace( level );
+
+    /* smoothen is called very often on small coarse grids, so keep the
+    monitoring cheap with pre-registered regions */
+    MINIMON_REGION( region_smoothen, "smoothen" );
+    MINIMON_REGION( region_inner, "smoothen_inner" );
+    MINIMON_REGION( region_wait, "smoothen_wait" );
+    MINIMON_REGION( region_collect, "smoothen_collect" );
+    MINIMON_REGION( region_outer, "smoothen_outer" );
+    MINIMON_REGION( region_wait_res, "smoothen_wait_res" );
+    MINIMON_REGION( region_wait_assisted, "smoothen_wait_assisted" );
+    MINIMON_REGION( region_wait_unassisted, "smoothen_wait_unassisted" );
+    MINIMON_REGION( region_polls, "progress_polls" );
+
+    uint32_t par= level.src_grid->team().size();
+
+    // smoothen
+    minimon.start( region_smoothen );
+
+    level.src_grid->barrier();
+
+    size_t ld= level.src_grid->local.extent(0);
+    size_t lh= level.src_grid->local.extent(1);
+    size_t lw= level.src_grid->local.extent(2);
+
+    double localres= 0.0;
+
+    double ax= level.ax;
+    double ay= level.ay;
+    double az= level.az;
+    double ac= level.acenter;
+    double ff= level.ff;
+    double m= level.m;
+
+    const double c= coeff;
+
+    // async halo update
+    level.update_halo_async();
+
+    bool assisted= progress.begin();
+
+    // smoothen_inner
+    minimon.start( region_inner );
+
+    // update inner
+
+    /* the start value for both, the y loop and the x loop is 1 because either there is
+    a border area next to the halo -- then the first column or row is covered below in
+    the border update -- or there is an outside border -- then the first column or row
+    contains the boundary values. */
+#if 1
+    auto p_rhs=   level.rhs_grid->lbegin();
+    level.src_op->inner.update(level.dst_grid->lbegin(),
+        [&](auto* center, auto* center_dst, auto offset, const auto& offsets) {
+                ValueT dtheta= m * (
+                    ff * p_rhs[offset] -
+                    ax * ( center[offsets[4]] + center[offsets[5]] ) -
+                    ay * ( center[offsets[2]] + center[offsets[3]] ) -
+                    az * ( center[offsets[0]] + center[offsets[1]] ) -
+                    ac * *center );
+                localres= std::max( localres, maxabs( dtheta ) );
+                *center_dst = *center + c * dtheta;
+        });
+#else
+    auto next_layer_off = lw * lh;
+    auto core_offset = lw * (lh + 1) + 1;
+    for ( size_t z= 1; z < ld-1; z++ ) {
+        for ( size_t y= 1; y < lh-1; y++ ) {
+
+            /* this should eventually be done with Alpaka or Kokkos to look
+            much nicer but still be fast */
+
+            const ValueT* __restrict p_core=  level.src_grid->lbegin() + core_offset;
+            const ValueT* __restrict p_east=  p_core + 1;
+            const ValueT* __restrict p_west=  p_core - 1;
+            const ValueT* __restrict p_north= p_core + lw;
+            const ValueT* __restrict p_south= p_core - lw;
+            const ValueT* __restrict p_up=    p_core + next_layer_off;
+            const ValueT* __restrict p_down=  p_core - next_layer_off;
+            const ValueT* __restrict p_rhs=   level.rhs_grid->lbegin() + core_offset;
+            ValueT* __restrict p_new= level.dst_grid->lbegin() + core_offset;
+
+            for ( size_t x= 1; x < lw-1; x++ ) {
+
+                /*
+                stability condition: r <= 1/2 with r= dt/h^2 ==> dt <= 1/2*h^2
+                dtheta= ru*u_plus + ru*u_minus - 2*ru*u_center with ru=dt/hu^2 <= 1/2
+                */
+                ValueT dtheta= m * (
+                    ff * *p_rhs -
+                    ax * ( *p_east + *p_west ) -
+                    ay * ( *p_north + *p_south ) -
+                    az * ( *p_up + *p_down ) -
+                    ac * *p_core );
+                *p_new= *p_core + c * dtheta;
+
+                localres= std::max( localres, maxabs( dtheta ) );
+
+                p_core++;
+                p_east++;
+                p_west++;
+                p_north++;
+                p_south++;
+                p_up++;
+                p_down++;
+                p_rhs++;
+                p_new++;
+            }
+            core_offset += lw;
+        }
+        core_offset += 2 * lw;
+    }
+#endif
+    /* the bytes are the compulsory memory traffic per element: the src and the rhs value
+    are read once, the dst value is written once and read once for the write-allocate.
+    The other 6 stencil values come from the caches. */
+    minimon.stop( region_inner, par, /* elements */ (ld-2)*(lh-2)*(lw-2), /* flops */ 16*(ld-2)*(lh-2)*(lw-2)*batch_size, /* bytes read */ 3*(ld-2)*(lh-2)*(lw-2)*sizeof(ValueT), /* bytes written */ (ld-2)*(lh-2)*(lw-2)*sizeof(ValueT) );
+
+    if ( assisted ) {
+        minimon.record( region_polls, par, ld*lh*lw, progress.end() );
+    }
+    MiniMon::Handle region_wait_progress= assisted ? region_wait_assisted : region_wait_unassisted;
+
+    // smoothen_wait
+    minimon.start( region_wait );
+    // smoothen_wait_assisted or smoothen_wait_unassisted
+    if ( progress.enabled() ) minimon.start( region_wait_progress );
+    // wait for async halo update
+
+    level.wait_halo();
+    update_mirror_halos( level );
+
+    if ( progress.enabled() ) minimon.stop( region_wait_progress, par, /* elements */ ld*lh*lw );
+    minimon.stop( region_wait, par, /* elements */ ld*lh*lw );
+
+    // smoothen_collect
+    minimon.start( region_collect );
+
+    /* unit 0 (of any active team) waits until all local residuals from all
+    other active units are in */
+    res.collect_and_spread( level.src_grid->team() );
+
+    minimon.stop( region_collect, par );
+
+    // smoothen_outer
+    minimon.start( region_outer );
+
+    /// begin pointer of local block, needed because halo border iterator is read-only
+    auto grid_local_begin= level.dst_grid->lbegin();
+    auto rhs_grid_local_begin= level.rhs_grid->lbegin();
+
+    auto bend = level.src_op->boundary.end();
+    // update border area
+    for( auto it = level.src_op->boundary.begin(); it != bend; ++it ) {
+
+        ValueT dtheta= m * (
+            ff * rhs_grid_local_begin[ it.lpos() ] -
+            ax * ( it.value_at(4) + it.value_at(5) ) -
+            ay * ( it.value_at(2) + it.value_at(3) ) -
+            az * ( it.value_at(0) + it.value_at(1) ) -
+            ac * *it );
+        grid_local_begin[ it.lpos() ]= *it + c * dtheta;
+
+        localres= std::max( localres, maxabs( dtheta ) );
+    }
+
+    minimon.stop( region_outer, par, /* elements */ 2*(ld*lh+lh*lw+lw*ld),
+        /* flops */ 2*16*(ld*lh+lh*lw+lw*ld)*batch_size, /* bytes read */ 2*3*(ld*lh+lh*lw+lw*ld)*sizeof(ValueT), /* bytes written */ 2*(ld*lh+lh*lw+lw*ld)*sizeof(ValueT) );
+
+    // smoothen_wait_res
+    minimon.start( region_wait_res );
+
+    res.wait( level.src_grid->team() );
+
+    /* global residual from former iteration */
+    double oldres= res.get();
+
+    res.set( &localres, level.src_grid->team() );
+
+    minimon.stop( region_wait_res, par );
+
+    /* safe point for a live snapshot of this unit, see MiniMon::snapshot_requested(),
+    it needs no communication of its own */
+    static uint64_t sweeps= 0;
+    ++sweeps;
+    if ( minimon.snapshot_requested() ) {
+        minimon.snapshot( dash::myid(), { "sweep=" + std::to_string( sweeps ),
+            "residual=" + std::to_string( oldres ), "local=" + std::to_string( ld*lh*lw ) } );
+    }
+
+    level.swap();
+
+    minimon.stop( region_smoothen, par, /* elements */ ld*lh*lw,
+        /* flops */ 16*ld*lh*lw*batch_size, /* bytes read */ 3*ld*lh*lw*sizeof(ValueT), /* bytes written */ ld*lh*lw*sizeof(ValueT) );
+
+    return oldres;
+}
+
+
+/**
+Smoothen the given level at most beta times or until the global residual is below epsilon.
+
+With adapt > 0.0 it also stops as soon as the reduction of the global residual per sweep
+degrades past adapt, i.e., when res_j > adapt * res_j-1. Then Jacobi is stalling on the
+low-frequency error and the coarser grid should take over. Since the residual from the
+Allreduce lags one sweep behind, the first ratio is known after the third sweep. All units
+see the same residual, therefore they all stop after the same sweep.
+
+Returns the number of sweeps done.
+*/
+uint32_t smoothen_adaptive( Level& level, Allreduce& res, uint32_t beta, double epsilon, double adapt ) {
+
+    uint32_t j= 0;
+    double lastres= std::numeric_limits<double>::max();
+    res.reset( level.src_grid->team() );
+    while ( res.get() > epsilon && j < beta ) {
+
+        /* need global residual for iteration count */
+        smoothen( level, res );
+        j++;
+
+        double currentres= res.get();
+        if ( 0.0 < adapt && std::numeric_limits<double>::max() > lastres &&
+                currentres > adapt * lastres ) {
+            break;
+        }
+        lastres= currentres;
+    }
+
+    return j;
+}
+
+//#define DETAILOUTPUT 1
+
+template<typename Iterator>
+static void recursive_cycle_level( Iterator it, Iterator itend,
+        uint32_t beta, uint32_t gamma, double epsilon, double adapt, Allreduce& res ) {
+    SCOREP_USER_FUNC()
+
+    MINIMON_REGION( region_sweeps_down, "sweeps_down" );
+    MINIMON_REGION( region_sweeps_up, "sweeps_up" );
+
+    Iterator itnext( it );
+    ++itnext;
+    /* reached end of recursion? */
+    if ( itend == itnext ) {
+
+        /* smoothen completely  */
+        uint32_t j= 0;
+        res.reset( (*it)->src_grid->team() );
+        while ( res.get() > epsilon ) {
+            /* need global residual for iteration count */
+            smoothen( **it, res );
+
+            j++;
+        }
+        if ( 0 == dash::myid() ) {
+            cout << "smoothing " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) << " coarsest " << j << " times with residual " << res.get() << endl;
+        }
+
+        return;
+    }
+
+    /* stepped on the dummy level? ... which is there to signal that it is not
+    the end of the parallel recursion on the coarsest level but a subteam is
+    going on to solve the coarser levels and this unit is not in that subteam.
+    ... sounds complicated, is complicated, change only if you know what you
+    are doing. */
+    if ( NULL == *itnext ) {
+
+        /* barrier 'Alice', belongs together with the next barrier 'Bob' below */
+        (*it)->src_grid->team().barrier();
+
+        cout << "all meet again here: I'm passive unit " << dash::myid() << endl;
+
+        return;
+    }
+
+    /* stepped on the replicated coarse levels? Every unit runs them alone with the
+    residual of its single unit team and keeps its own block of the correction. */
+    if ( (*itnext)->replica ) {
+
+        replicate( **it, **itnext );
+
+        recursive_cycle( itnext, itend, beta, gamma, epsilon, adapt, (*itnext)->replica->res );
+
+        unreplicate( **itnext, **it );
+        return;
+    }
+
+    /* stepped on a transfer level? */
+    if ( (*it)->src_grid->team().size() != (*itnext)->src_grid->team().size() ) {
+
+        /* only the members of the reduced team need to work, all others do siesta. */
+        //if ( 0 == (*itnext)->grid.team().position() )
+        assert( 0 == (*itnext)->src_grid->team().position() );
+        {
+
+            cout << "transfer to " <<
+                (*it)->src_grid->extent(2) << "×" <<
+                (*it)->src_grid->extent(1) << "×" <<
+                (*it)->src_grid->extent(0) << " with " << (*it)->src_grid->team().size() << " units "
+                " ⇒ " <<
+                (*itnext)->src_grid->extent(2) << "×" <<
+                (*itnext)->src_grid->extent(1) << "×" <<
+                (*itnext)->src_grid->extent(0) << " with " << (*itnext)->src_grid->team().size() << " units " << endl;
+
+            transfertofewer( **it, **itnext );
+
+            /* don't apply a gamma != 1 here! */
+            recursive_cycle( itnext, itend, beta, gamma, epsilon, adapt, res );
+
+            cout << "transfer back " <<
+            (*itnext)->src_grid->extent(2) << "×" <<
+            (*itnext)->src_grid->extent(1) << "×" <<
+            (*itnext)->src_grid->extent(0) << " with " << (*itnext)->src_grid->team().size() << " units "
+            " ⇒ " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) << " with " << (*it)->src_grid->team().size() << " units " <<  endl;
+
+            transfertomore( **itnext, **it );
+        }
+
+        /* barrier 'Bob', belongs together with the previous barrier 'Alice' above */
+        (*it)->src_grid->team().barrier();
+
+
+        cout << "all meet again here: I'm active unit " << dash::myid() << endl;
+        return;
+    }
+
+
+    /* **** normal recursion **** **** **** **** **** **** **** **** **** */
+
+    uint32_t par= (*it)->src_grid->team().size();
+    uint64_t elements= (*it)->src_grid->local_size();
+
+    /* smoothen fixed number of times, or fewer in adaptive mode */
+    uint32_t j= smoothen_adaptive( **it, res, beta, epsilon, adapt );
+    minimon.record( region_sweeps_down, par, elements, j );
+    if ( 0 == dash::myid()  ) {
+        cout << "smoothing " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) << " on way down " << j << " times with residual " << res.get() << endl;
+    }
+
+    /* scale down */
+    if ( 0 == dash::myid() ) {
+        cout << "scale down " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) <<
+            " ⇒ " <<
+            (*itnext)->src_grid->extent(2) << "×" <<
+            (*itnext)->src_grid->extent(1) << "×" <<
+            (*itnext)->src_grid->extent(0) << endl;
+    }
+
+    scaledown( **it, **itnext );
+
+    /* recurse  */
+    for ( uint32_t g= 0; g < gamma; ++g ) {
+        recursive_cycle( itnext, itend, beta, gamma, epsilon, adapt, res );
+    }
+
+    /* scale up */
+    if ( 0 == dash::myid() ) {
+        cout << "scale up " <<
+            (*itnext)->src_grid->extent(2) << "×" <<
+            (*itnext)->src_grid->extent(1) << "×" <<
+            (*itnext)->src_grid->extent(0) <<
+            " ⇒ " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) << endl;
+    }
+    scaleup( **itnext, **it );
+
+    j= smoothen_adaptive( **it, res, beta, epsilon, adapt );
+    minimon.record( region_sweeps_up, par, elements, j );
+    if ( 0 == dash::myid() ) {
+        cout << "smoothing " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) << " on way up " << j << " times with residual " << res.get() << endl;
+    }
+}
+
+
+template<typename Iterator>
+void recursive_cycle( Iterator it, Iterator itend,
+        uint32_t beta, uint32_t gamma, double epsilon, double adapt, Allreduce& res ) {
+
+    TraceLevel trace( **it );
+
+    /* one region per level, nested like the recursion, such that the call tree
+    shows the share of every coarser level in the cycle on the finer one */
+    MiniMon::Handle region= (*it)->cycle_region;
+    uint32_t par= (*it)->src_grid->team().size();
+    uint64_t elements= (*it)->src_grid->local_size();
+
+    // cycle_<level>
+    minimon.start( region );
+
+    recursive_cycle_level( it, itend, beta, gamma, epsilon, adapt, res );
+
+    minimon.stop( region, par, elements );
+}
+
+
+template void recursive_cycle( vector<Level*>::iterator it, vector<Level*>::iterator itend,
+        uint32_t beta, uint32_t gamma, double epsilon, double adapt, Allreduce& res );
+
+
+/* Communication skeleton of smoothen(): the same barrier, halo exchange and
+lagged Allreduce, but no stencil math. The residual is a dummy value. */
+void skeleton_smoothen( Level& level, Allreduce& res ) {
+
+    TraceLevel trace( level );
+
+    MINIMON_REGION( region_halo, "skeleton_halo" );
+    MINIMON_REGION( region_allreduce, "skeleton_allreduce" );
+
+    uint32_t par= level.src_grid->team().size();
+    uint64_t elements= level.src_grid->local_size();
+
+    // skeleton_halo
+    minimon.start( region_halo );
+
+    level.src_grid->barrier();
+    level.update_halo_async();
+    level.wait_halo();
+    update_mirror_halos( level );
+
+    minimon.stop( region_halo, par, elements );
+
+    // skeleton_allreduce
+    minimon.start( region_allreduce );
+
+    double localres= 1.0;
+    res.collect_and_spread( level.src_grid->team() );
+    res.wait( level.src_grid->team() );
+    res.set( &localres, level.src_grid->team() );
+
+    minimon.stop( region_allreduce, par, elements );
+
+    level.swap();
+}
+
+
+/* Communication skeleton of scaledown() and scaleup(): the halo exchange of
+the source grid and the barrier of the fill of the target grid */
+static void skeleton_transfer( Level& from, Level& to, MiniMon::Handle region ) {
+
+    TraceLevel trace( from );
+
+    // skeleton_scaledown or skeleton_scaleup
+    minimon.start( region );
+
+    from.update_halo_async();
+    from.wait_halo();
+    update_mirror_halos( from );
+    to.src_grid->barrier();
+
+    minimon.stop( region, from.src_grid->team().size(), from.src_grid->local_size() );
+}
+
+
+/* Same recursion as recursive_cycle() including the team splits and the
+transfers between teams, but with the skeletons of the kernels and always
+beta sweeps per smoothing, also on the coarsest level. The MiniMon regions
+skeleton_* give the communication cost per level by par and elements. */
+template<typename Iterator>
+void skeleton_cycle( Iterator it, Iterator itend, uint32_t beta, uint32_t gamma, Allreduce& res ) {
+
+    MINIMON_REGION( region_scaledown, "skeleton_scaledown" );
+    MINIMON_REGION( region_scaleup, "skeleton_scaleup" );
+    MINIMON_REGION( region_tofewer, "skeleton_transfertofewer" );
+    MINIMON_REGION( region_tomore, "skeleton_transfertomore" );
+
+    Iterator itnext( it );
+    ++itnext;
+
+    if ( itend == itnext ) {
+
+        res.reset( (*it)->src_grid->team() );
+        for ( uint32_t j= 0; j < beta; ++j ) skeleton_smoothen( **it, res );
+        return;
+    }
+
+    /* passive unit, see recursive_cycle(), barrier 'Alice' */
+    if ( NULL == *itnext ) {
+
+        (*it)->src_grid->team().barrier();
+        return;
+    }
+
+    if ( (*itnext)->replica ) {
+
+        replicate( **it, **itnext );
+        skeleton_cycle( itnext, itend, beta, gamma, (*itnext)->replica->res );
+        unreplicate( **itnext, **it );
+        return;
+    }
+
+    if ( (*it)->src_grid->team().size() != (*itnext)->src_grid->team().size() ) {
+
+        assert( 0 == (*itnext)->src_grid->team().position() );
+
+        uint32_t par= (*it)->src_grid->team().size();
+        uint64_t elements= (*it)->src_grid->local_size();
+
+        // skeleton_transfertofewer
+        minimon.start( region_tofewer );
+        transfertofewer( **it, **itnext );
+        minimon.stop( region_tofewer, par, elements );
+
+        skeleton_cycle( itnext, itend, beta, gamma, res );
+
+        // skeleton_transfertomore
+        minimon.start( region_tomore );
+        transfertomore( **itnext, **it );
+        minimon.stop( region_tomore, par, elements );
+
+        /* barrier 'Bob' */
+        (*it)->src_grid->team().barrier();
+        return;
+    }
+
+    res.reset( (*it)->src_grid->team() );
+    for ( uint32_t j= 0; j < beta; ++j ) skeleton_smoothen( **it, res );
+
+    skeleton_transfer( **it, **itnext, region_scaledown );
+
+    for ( uint32_t g= 0; g < gamma; ++g ) {
+        skeleton_cycle( itnext, itend, beta, gamma, res );
+    }
+
+    skeleton_transfer( **itnext, **it, region_scaleup );
+
+    res.reset( (*it)->src_grid->team() );
+    for ( uint32_t j= 0; j < beta; ++j ) skeleton_smoothen( **it, res );
+}
+
+
+template void skeleton_cycle( vector<Level*>::iterator it, vector<Level*>::iterator itend,
+        uint32_t beta, uint32_t gamma, Allreduce& res );
+
+
+void smoothen_final( Level& level, double epsilon, Allreduce& res ) {
+    SCOREP_USER_FUNC()
+
+    TraceLevel trace( level );
+
+    uint64_t par= level.src_grid->team().size() ;
+
+    // smooth_final
+    minimon.start( "smooth_final" );
+
+    uint32_t j= 0;
+    res.reset( level.src_grid->team() );
+    while ( res.get() > epsilon ) {
+
+        smoothen( level, res );
+        j++;
+    }
+    if ( 0 == dash::myid() ) {
+        cout << "smoothing: " << j << " steps finest with residual " << res.get() << endl;
+    }
+
+/////////////////////////////////////////
+#ifdef DETAILOUTPUT
+if ( 0 == dash::myid()  ) {
+    cout << "== after final smoothing ==" << endl;
+    cout << "  src_grid" << endl;
+    level.printout();
+    cout << "  rhs_grid" << endl;
+    level.printout_rhs();
+}
+#endif /* DETAILOUTPUT */
+
+    minimon.stop( "smooth_final", par );
+}
@@ -0,0 +1,569 @@
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include <iostream>
+#include <cassert>
+#include <array>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "allreduce.h"
+#include "batch.h"
+#include "minimonitoring.h"
+
+/* one monitoring instance per unit, shared by the library and the drivers */
+extern MiniMon minimon;
+
+using TeamSpecT = dash::TeamSpec<3>;
+using MatrixT = dash::NArray<ValueT,3>;
+using PatternT = typename MatrixT::pattern_type;
+using StencilT = dash::halo::StencilPoint<3>;
+using StencilSpecT = dash::halo::StencilSpec<StencilT,26>;
+using CycleSpecT = dash::halo::GlobalBoundarySpec<3>;
+using HaloT = dash::halo::HaloMatrixWrapper<MatrixT>;
+using StencilOpT = dash::halo::StencilOperator<ValueT,PatternT,StencilSpecT>;
+
+/* for the smoothing operation, only the 6-point stencil is needed.
+However, the prolongation operation also needs the */
+constexpr StencilSpecT stencil_spec(
+    StencilT(0.5, -1, 0, 0), StencilT(0.5, 1, 0, 0),
+    StencilT(0.5,  0,-1, 0), StencilT(0.5, 0, 1, 0),
+    StencilT(0.5,  0, 0,-1), StencilT(0.5, 0, 0, 1),
+
+    StencilT(0.25, -1,-1, 0), StencilT( 0.25, 1, 1, 0),
+    StencilT(0.25, -1, 0,-1), StencilT( 0.25, 1, 0, 1),
+    StencilT(0.25,  0,-1,-1), StencilT( 0.25, 0, 1, 1),
+    StencilT(0.25, -1, 1, 0), StencilT( 0.25, 1,-1, 0),
+    StencilT(0.25, -1, 0, 1), StencilT( 0.25, 1, 0,-1),
+    StencilT(0.25,  0,-1, 1), StencilT( 0.25, 0, 1,-1),
+
+    StencilT(0.125, -1,-1,-1), StencilT( 0.125, 1,-1,-1),
+    StencilT(0.125, -1,-1, 1), StencilT( 0.125, 1,-1, 1),
+    StencilT(0.125, -1, 1,-1), StencilT( 0.125, 1, 1,-1),
+    StencilT(0.125, -1, 1, 1), StencilT( 0.125, 1, 1, 1));
+
+constexpr CycleSpecT cycle_spec(
+    dash::halo::BoundaryProp::CUSTOM,
+    dash::halo::BoundaryProp::CUSTOM,
+    dash::halo::BoundaryProp::CUSTOM );
+
+/* Boundary values of a level, computed once and shared by both halos of the double
+buffering. Only the bottom and top z faces can vary, a unit stores them only if its
+block touches them, and only for the y and x range of its block plus the ring of
+halo elements around it. All other boundary elements have the value side. A constant
+boundary has no faces. */
+struct Boundary {
+
+    using index_t = dash::default_index_t;
+
+    ValueT side= 0.0;
+    /* global z coordinate of the top face, the bottom face is at -1 */
+    index_t ztop= 0;
+    /* global y and x of the first element of the local block */
+    index_t y0= 0, x0= 0;
+    /* local extents in y and x plus 2 */
+    index_t ny= 0, nx= 0;
+    std::vector<ValueT> bottom;
+    std::vector<ValueT> top;
+
+    bool constant() const { return bottom.empty() && top.empty(); }
+
+    /* position of global y, x in bottom and top */
+    size_t pos( index_t y, index_t x ) const { return (y-y0+1)*nx + (x-x0+1); }
+
+    /* value at global boundary coordinates */
+    template< typename CoordsT >
+    ValueT at( const CoordsT& coords ) const {
+
+        if ( -1 == coords[0] && ! bottom.empty() ) return bottom[ pos( coords[1], coords[2] ) ];
+        if ( ztop == coords[0] && ! top.empty() ) return top[ pos( coords[1], coords[2] ) ];
+        return side;
+    }
+};
+
+/* Arrangement of the units of a team in z, y, x for the block distribution of the
+grids, see make_teamspec(). BALANCED is TeamSpec::balance_extents(), EXPLICIT uses
+the given units per dimension if they match the team size, AUTO picks the one with
+the lowest predicted cost of a halo exchange with the given latency per message in
+seconds and bandwidth in bytes per second. Coarse levels of at most replicate points
+are replicated on every unit, see replicate(). */
+struct Decomposition {
+
+    enum Mode { BALANCED, EXPLICIT, AUTO };
+
+    Mode mode= BALANCED;
+    std::array< size_t, 3 > units= {{ 1, 1, 1 }};
+    double latency= 2.0e-6;
+    double bandwidth= 5.0e9;
+
+    /* if > 0, the largest tolerated excess of the largest local block on the finest
+    grid of a team over an even split of the points, e.g. 0.05 for 5%, see plan_levels() */
+    double balance= 0.0;
+
+    /* if > 0, the grid points up to which a coarse level is solved redundantly */
+    size_t replicate= 0;
+
+    /* if > 0, the levels where the largest face of a block has at most this many bytes
+    exchange their halos with PackedHalo */
+    size_t packed= 0;
+};
+
+/* Halo exchange with one contiguous message per neighbor unit, for the coarse levels
+where the messages of HaloMatrixWrapper::update_async() per halo region are too small
+to be anything but latency. Every unit packs the elements that a neighbor needs into
+one buffer, in the row-major order of the box of the intersection of its block with
+the neighbor's block grown by 1, and puts it into the receive buffer of the neighbor
+in the slot of the direction it comes from. wait() finishes all puts, waits for the
+puts of the neighbors with a barrier and unpacks into the halo elements. Edges and
+corners are sent directly to the diagonal neighbors, there are no staged exchanges
+over the faces. The custom halos at the global boundary and the mirror halos are not
+touched. Between two exchanges of the same grid, the team needs to meet in a barrier,
+as in smoothen(). */
+class PackedHalo {
+
+public:
+
+    PackedHalo( MatrixT& grid, HaloT& halo );
+
+    void update_async();
+    void wait();
+
+private:
+
+    struct Neighbor {
+
+        dash::team_unit_t unit;
+        size_t begin, end; /* range in _send */
+        size_t remote; /* global index in _recv */
+    };
+
+    MatrixT& _grid;
+    dash::Array<ValueT> _recv;
+    std::vector<ValueT> _send;
+    std::vector<size_t> _send_local; /* local offset in _grid for every element of _send */
+    std::vector<size_t> _recv_local; /* local offset in _recv for every element of _recv_halo */
+    std::vector<ValueT*> _recv_halo;
+    std::vector<Neighbor> _neighbors;
+    std::vector< dash::Future< dash::Array<ValueT>::iterator > > _puts;
+};
+
+/* The first level of a replicated coarse solve has a team of a single unit for every
+unit of the team of the distributed level before, see replicate(). It needs the buffer
+for the gather over the distributed team and its own residual, because the Allreduce
+of the solver only works in subteams with the first unit of its team. */
+struct Replica {
+
+    /* block is the largest number of local elements of a unit of team */
+    Replica( dash::Team& team, dash::Team& single, size_t block ) :
+        gather( 2*block*team.size(), dash::BLOCKED, team ), res( single ) {}
+
+    dash::Array<ValueT> gather;
+    Allreduce res;
+};
+
+/* Optional helper thread per unit that drives the progress of the outstanding one-sided
+transfers while the unit computes. With one-sided MPI, the halo transfers started by
+update_async() and the asynchronous sets of the Allreduce often only move in the next
+MPI call of the unit, i.e., in wait(), and the overlap with the inner sweep of
+smoothen() is lost. Between begin() and end(), the thread enters the MPI progress
+engine every interval with MPI_Iprobe(). This needs MPI_THREAD_MULTIPLE, see
+dash::init_thread().
+
+To see how much of smoothen_wait it hides, every sample-th sweep can run without the
+thread. The waits are recorded per level as smoothen_wait_assisted and
+smoothen_wait_unassisted, see hidden(). Without sampling all sweeps use the thread. */
+class Progress {
+
+public:
+
+    ~Progress() { stop(); }
+
+    void start( std::chrono::microseconds interval, uint32_t sample= 0 );
+    void stop();
+    bool enabled() const { return _thread.joinable(); }
+
+    /* whether the thread is used for the next sweep, returns false for every
+    sample-th one */
+    bool begin();
+    /* returns the number of polls since begin() */
+    uint64_t end();
+
+    /* fraction of the unassisted wait time hidden by the thread, from the MiniMon
+    regions smoothen_wait_assisted and smoothen_wait_unassisted. The mean waits are
+    compared per level, i.e., per par and elements, and weighted with the assisted
+    calls of the level. The fraction per level is recorded as progress_hidden. */
+    static double hidden();
+
+private:
+
+    void run();
+
+    std::thread _thread;
+    std::chrono::microseconds _interval{ 0 };
+    uint32_t _sample= 0;
+    std::atomic<bool> _running{ false };
+    std::atomic<bool> _active{ false };
+    std::atomic<uint64_t> _polls{ 0 };
+    uint64_t _sweeps= 0;
+};
+
+extern Progress progress;
+
+struct Level {
+
+public:
+  using SizeSpecT = dash::SizeSpec<3>;
+  using DistSpecT = dash::DistributionSpec<3>;
+
+
+    /* now with double-buffering. src_grid and src_halo should only be read,
+    newgrid should only be written. dst_grid and dst_halo are only there to keep the other ones
+    before both are swapped in swap() */
+
+public:
+    MatrixT* src_grid;
+    MatrixT* dst_grid;
+    MatrixT* rhs_grid; /* right hand side, doesn't need a halo */
+    HaloT* src_halo;
+    HaloT* dst_halo;
+    StencilOpT* src_op;
+    StencilOpT* dst_op;
+
+
+    /* this are the values of the 7 non-zero matrix values -- only 4 different values, though,
+    because the matrix is symmetric */
+    double acenter, ax, ay, az;
+    /* this is the factor for the right hand side, which is 0 at the finest grid. */
+    double ff;
+    /* Diagonal element of matrix M, which is the inverse of the diagonal of matrix A.
+    This factor multiplies the defect in $ f - Au $. */
+    double m;
+
+    /* sz, sy, sx are the dimensions in meters of the grid excluding the boundary regions */
+    double sz, sy, sx;
+
+    /* grid spacing per dimension, doubled on a coarser level in every dimension that
+    is coarsened, see plan_levels() */
+    double hz, hy, hx;
+
+    /* the maximum time step according to the stability condition for the
+    time simulation mode */
+    double dt;
+
+    /* symmetry mode: per dimension, whether the grid only holds the lower half [0,c]
+    of the full grid, where c is the center plane. The other half is the mirror image,
+    the halo behind c is refreshed from the plane before c, see update_mirror_halos(). */
+    std::array< bool, 3 > mirror;
+
+    /* the boundary values set by initboundary() or initboundary_zero() */
+    Boundary boundary;
+
+    /* only set for the first level of a replicated coarse solve, see Replica */
+    std::unique_ptr<Replica> replica;
+
+    /* MiniMon region cycle_<nx>x<ny>x<nz> of this level, registered once here such
+    that recursive_cycle() needs no lookup by name */
+    MiniMon::Handle cycle_region;
+
+    /* the packed halo exchange of src_grid and dst_grid if enabled, see enable_packed_halo() */
+    PackedHalo* src_packed= nullptr;
+    PackedHalo* dst_packed= nullptr;
+
+    /* the prolongation operator of src_grid and dst_grid for scaleup() from a semi-coarsened
+    level, see enable_prolongation() and setup_prolongation() */
+    StencilOpT* src_prolong= nullptr;
+    StencilOpT* dst_prolong= nullptr;
+
+    /*
+    lz, ly, lx are the dimensions in meters of the grid including the boundary regions,
+    nz, ny, nx are th number of inner grid points per dimension, excluding the boundary regions,
+    therefore, lz,ly,lx are discretized into (nz+2)*(ny+2)*(nx+2) grid points.
+    With mirror_dims, nz, ny, nx are the extents of the stored part of the grid only.
+    blocks are the block sizes per dimension, see distribution().
+    */
+    Level( double lz, double ly, double lx,
+           size_t nz, size_t ny, size_t nx,
+           dash::Team& team, TeamSpecT teamspec,
+           std::array< bool, 3 > mirror_dims= {{ false, false, false }},
+           const std::array< size_t, 3 >& blocks= {{ 0, 0, 0 }} ) :
+            _phase_alloc( nullptr, "setup_alloc", team.size(), nz*ny*nx ),
+            _grid_1( SizeSpecT( nz, ny, nx ), distribution( blocks, nz, ny, nx ), team, teamspec ),
+            _grid_2( SizeSpecT( nz, ny, nx ), distribution( blocks, nz, ny, nx ), team, teamspec ),
+            _rhs_grid( SizeSpecT( nz, ny, nx ), distribution( blocks, nz, ny, nx ), team, teamspec ),
+            _phase_halo( "setup_alloc", "setup_halo", team.size(), nz*ny*nx ),
+        _halo_grid_1( _grid_1, cycle_spec, stencil_spec ),
+        _halo_grid_2( _grid_2, cycle_spec, stencil_spec ),
+        _stencil_op_1(_halo_grid_1.stencil_operator(stencil_spec)),
+        _stencil_op_2(_halo_grid_2.stencil_operator(stencil_spec)),
+        src_grid(&_grid_1), dst_grid(&_grid_2), rhs_grid(&_rhs_grid),
+        src_halo(&_halo_grid_1), dst_halo(&_halo_grid_2),
+        src_op(&_stencil_op_1),dst_op(&_stencil_op_2) {
+
+        assert( 1 < nz );
+        assert( 1 < ny );
+        assert( 1 < nx );
+
+        cycle_region= minimon.region( "cycle_" + std::to_string( nx ) + "x" +
+            std::to_string( ny ) + "x" + std::to_string( nz ) );
+
+        sz= lz;
+        sy= ly;
+        sx= lx;
+
+        mirror= mirror_dims;
+
+        hz= lz/(full_extent(0)+1);
+        hy= ly/(full_extent(1)+1);
+        hx= lx/(full_extent(2)+1);
+
+        /* This is the original setting for the linear system. */
+
+        /* stability condition: r <= 1/2 with r= dt/h^2 ==> dt <= 1/2*h^2
+        dtheta= ru*u_plus + ru*u_minus - 2*ru*u_center with ru=dt/hu^2 <= 1/2 */
+        double hmin= std::min( hz, std::min( hy, hx ) );
+        dt= 0.5*hmin*hmin;
+
+        ax= -1.0/hx/hx;
+        ay= -1.0/hy/hy;
+        az= -1.0/hz/hz;
+        acenter= -2.0*(ax+ay+az);
+        m= 1.0 / acenter;
+
+        ff= 1.0; /* factor for right-hand-side */
+
+        minimon.stop( "setup_halo", team.size(), nz*ny*nx );
+
+        /* no barrier needed, the grids and halos above are collective already */
+        if ( 0 == team.myid() ) {
+            std::cout << "Level " <<
+                "dim. " << lz << "m×" << ly << "m×" << lz << "m " <<
+                "in grid of " << nz << "×" << ny << "×" << nx <<
+                " h_= " << hz << "," << hy << "," << hx <<
+                " mirrored " << mirror[0] << mirror[1] << mirror[2] <<
+                " with team of " << team.size() <<
+                " ⇒ a_= " << acenter << "," << ax << "," << ay << "," << az <<
+                " , m= " << m << " , ff= " << ff <<std::endl;
+        }
+    }
+
+    /***
+    Alternative version of the constructor that takes the parent Level as the first argument.
+    From this, it can get the original physical dimensions lz, ly, lx and the original
+    grid distances hy, hy, hx.
+    nz, ny, nx are th number of inner grid points per dimension, excluding the boundary regions.
+    Per dimension, they are either the same as in the parent (not coarsened, also for the
+    transfer levels in elastic mode) or half of it, rounded down, see plan_levels().
+    */
+    Level( const Level& parent,
+           size_t nz, size_t ny, size_t nx,
+           dash::Team& team, TeamSpecT teamspec,
+           const std::array< size_t, 3 >& blocks= {{ 0, 0, 0 }} ) :
+            _phase_alloc( nullptr, "setup_alloc", team.size(), nz*ny*nx ),
+            _grid_1( SizeSpecT( nz, ny, nx ), distribution( blocks, nz, ny, nx ), team, teamspec ),
+            _grid_2( SizeSpecT( nz, ny, nx ), distribution( blocks, nz, ny, nx ), team, teamspec ),
+            _rhs_grid( SizeSpecT( nz, ny, nx ), distribution( blocks, nz, ny, nx ), team, teamspec ),
+            _phase_halo( "setup_alloc", "setup_halo", team.size(), nz*ny*nx ),
+        _halo_grid_1( _grid_1, cycle_spec, stencil_spec ),
+        _halo_grid_2( _grid_2, cycle_spec, stencil_spec ),
+        _stencil_op_1(_halo_grid_1.stencil_operator(stencil_spec)),
+        _stencil_op_2(_halo_grid_2.stencil_operator(stencil_spec)),
+        src_grid(&_grid_1), dst_grid(&_grid_2), rhs_grid(&_rhs_grid),
+        src_halo(&_halo_grid_1), dst_halo(&_halo_grid_2),
+        src_op(&_stencil_op_1),dst_op(&_stencil_op_2) {
+
+        assert( 1 < nz );
+        assert( 1 < ny );
+        assert( 1 < nx );
+
+        cycle_region= minimon.region( "cycle_" + std::to_string( nx ) + "x" +
+            std::to_string( ny ) + "x" + std::to_string( nz ) );
+
+        sz= parent.sz;
+        sy= parent.sy;
+        sx= parent.sx;
+
+        mirror= parent.mirror;
+
+        hz= ( nz == parent.src_grid->extent(0) ) ? parent.hz : 2.0*parent.hz;
+        hy= ( ny == parent.src_grid->extent(1) ) ? parent.hy : 2.0*parent.hy;
+        hx= ( nx == parent.src_grid->extent(2) ) ? parent.hx : 2.0*parent.hx;
+
+        /* the operator of the actual grid spacing, the residual is restricted
+        without extra factor in scaledown() */
+        ax= -1.0/hx/hx;
+        ay= -1.0/hy/hy;
+        az= -1.0/hz/hz;
+        acenter= -2.0*(ax+ay+az);
+        m= 1.0 / acenter;
+
+        ff= parent.ff;
+        dt= parent.dt;
+
+        minimon.stop( "setup_halo", team.size(), nz*ny*nx );
+
+        if ( 0 == team.myid() ) {
+            std::cout << "Level with a parent level " <<
+                "in grid of " << nz << "×" << ny << "×" << nx <<
+                " h_= " << hz << "," << hy << "," << hx <<
+                " with team of " << team.size() <<
+                " ⇒ a_= " << acenter << "," << ax << "," << ay << "," << az <<
+                " , m= " << m << " , ff= " << ff << std::endl;
+        }
+    }
+
+    Level() = delete;
+
+    /** TILE distribution with the given block sizes per dimension, such that every unit
+    gets one block and the blocks of consecutive levels stay aligned, see plan_levels().
+    Block size 0 means BLOCKED. */
+    static DistSpecT distribution( const std::array< size_t, 3 >& blocks, size_t nz, size_t ny, size_t nx ) {
+
+        if ( 0 == blocks[0] || 0 == blocks[1] || 0 == blocks[2] ) {
+            return DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED );
+        }
+        return DistSpecT( dash::TILE( std::min( blocks[0], nz ) ), dash::TILE( std::min( blocks[1], ny ) ),
+            dash::TILE( std::min( blocks[2], nx ) ) );
+    }
+
+    /** extent of the full grid in dimension d, including the mirrored part */
+    size_t full_extent( uint32_t d ) const {
+
+        return mirror[d] ? 2*src_grid->extent(d)-1 : src_grid->extent(d);
+    }
+
+    /** swap grid and halos for the double buffering scheme */
+    void swap() {
+
+        std::swap( src_halo, dst_halo );
+        std::swap( src_grid, dst_grid );
+        std::swap( src_op, dst_op );
+        std::swap( src_packed, dst_packed );
+        std::swap( src_prolong, dst_prolong );
+    }
+
+    /** use PackedHalo instead of the halo regions for both grids, collective */
+    void enable_packed_halo() {
+
+        _packed_1.reset( new PackedHalo( _grid_1, _halo_grid_1 ) );
+        _packed_2.reset( new PackedHalo( _grid_2, _halo_grid_2 ) );
+        src_packed= ( src_grid == &_grid_1 ) ? _packed_1.get() : _packed_2.get();
+        dst_packed= ( src_grid == &_grid_1 ) ? _packed_2.get() : _packed_1.get();
+    }
+
+    /** build the operators with the given interpolation weights for both grids once */
+    void enable_prolongation( const StencilSpecT& spec ) {
+
+        _prolong_1.reset( new StencilOpT( _halo_grid_1.stencil_operator( spec ) ) );
+        _prolong_2.reset( new StencilOpT( _halo_grid_2.stencil_operator( spec ) ) );
+        src_prolong= ( src_grid == &_grid_1 ) ? _prolong_1.get() : _prolong_2.get();
+        dst_prolong= ( src_grid == &_grid_1 ) ? _prolong_2.get() : _prolong_1.get();
+    }
+
+    /** start and finish the halo exchange of src_grid */
+    void update_halo_async() {
+
+        if ( nullptr != src_packed ) src_packed->update_async(); else src_halo->update_async();
+    }
+
+    void wait_halo() {
+
+        if ( nullptr != src_packed ) src_packed->wait(); else src_halo->wait();
+    }
+
+    double max_dt() const {
+
+        /* stability condition: r <= 1/2 with r= dt/h^2 ==> dt <= 1/2*h^2
+        dtheta= ru*u_plus + ru*u_minus - 2*ru*u_center with ru=dt/hu^2 <= 1/2 */
+        std::cout << "    dt= " << dt << std::endl;
+        return dt;
+    }
+
+
+private:
+
+    /* The setup phases grid allocation and halo construction are timed in MiniMon
+    as setup_alloc and setup_halo. Both happen in the member initializer list,
+    therefore the markers are members in between the grids and the halos. */
+    struct SetupPhase {
+
+        SetupPhase( const char* stop, const char* start, uint32_t par, uint64_t elements ) {
+
+            if ( nullptr != stop ) minimon.stop( stop, par, elements );
+            minimon.start( start );
+        }
+    };
+
+    SetupPhase _phase_alloc;
+    MatrixT _grid_1;
+    MatrixT _grid_2;
+    MatrixT _rhs_grid;
+    SetupPhase _phase_halo;
+    HaloT _halo_grid_1;
+    HaloT _halo_grid_2;
+    StencilOpT _stencil_op_1;
+    StencilOpT _stencil_op_2;
+    std::unique_ptr<PackedHalo> _packed_1;
+    std::unique_ptr<PackedHalo> _packed_2;
+    std::unique_ptr<StencilOpT> _prolong_1;
+    std::unique_ptr<StencilOpT> _prolong_2;
+
+};
+
+
+/* the building blocks of the multigrid solver, see multigrid.cpp */
+
+size_t level_extent( uint32_t l, bool mirror );
+TeamSpecT make_teamspec( size_t units, const std::array< size_t, 3 >& extents,
+        const Decomposition& decomposition );
+
+/* extents and block sizes of one level of a team, see plan_levels() */
+struct LevelPlan {
+
+    std::array< size_t, 3 > extents;
+    std::array< size_t, 3 > blocks;
+};
+
+std::vector<LevelPlan> plan_levels( const std::array< size_t, 3 >& extents, std::array< double, 3 > h,
+        const std::array< bool, 3 >& mirror, const TeamSpecT& teamspec, size_t maxlevels, bool semicoarsening,
+        double balance );
+
+void initgrid( Level& level );
+void initboundary( Level& level );
+void initboundary_zero( Level& level );
+void setboundary( Level& level );
+
+void update_mirror_halos( Level& level );
+ValueT full_value_at( Level& level, size_t z, size_t y, size_t x );
+double team_max( dash::Team& team, double v );
+bool check_symmetry( Level& level, double eps );
+double report_imbalance( Level& level, size_t index );
+size_t largest_face_bytes( Level& level );
+
+void scaledownboundary( Level& fine, Level& coarse );
+void scaledown( Level& fine, Level& coarse );
+void setup_prolongation( Level& coarse, Level& fine );
+void scaleup( Level& coarse, Level& fine );
+void transfertofewer( Level& source, Level& dest );
+void replicate( Level& source, Level& dest );
+void unreplicate( Level& source, Level& dest );
+void transfertomore( Level& source, Level& dest );
+
+double smoothen( Level& level, Allreduce& res, double coeff= 1.0 );
+uint32_t smoothen_adaptive( Level& level, Allreduce& res, uint32_t beta, double epsilon, double adapt );
+void smoothen_final( Level& level, double epsilon, Allreduce& res );
+
+/* instantiated for std::vector<Level*>::iterator only */
+template<typename Iterator>
+void recursive_cycle( Iterator it, Iterator itend,
+        uint32_t beta, uint32_t gamma, double epsilon, double adapt, Allreduce& res );
+
+/* communication only versions for the skeleton mode, no stencil math */
+void skeleton_smoothen( Level& level, Allreduce& res );
+template<typename Iterator>
+void skeleton_cycle( Iterator it, Iterator itend, uint32_t beta, uint32_t gamma, Allreduce& res );
+
+#endif /* MULTIGRID_H */
@@ -64,11 +64,15 @@ plot \
     filename using 4:( strcol(2) eq "scaledown" ? $5/$7 : 1/0 ):($5/$8):($5/$9) with yerrorbars t "scaledown", \
     filename using 4:( strcol(2) eq "scaleup" ? $5/$7 : 1/0 ):($5/$8):($5/$9) with yerrorbars t "scaleup"
 
+filename_out=filename.".bandwidth.png"
+set output filename_out
+#set title "Foo"
+set ylabel "Bandwidth [GB/s]"
 
-
-
-
-
-
-
-
+set xrange[0.5:*]
+plot \
+    filename using 4:( strcol(2) eq "smoothen" ? $11 : 1/0 ) t "smoothen", \
+    filename using 4:( strcol(2) eq "smoothen_inner" ? $11 : 1/0 ) t "smoothen inner", \
+    filename using 4:( strcol(2) eq "smoothen_outer" ? $11 : 1/0 ) t "smoothen outer", \
+    filename using 4:( strcol(2) eq "scaledown" ? $11 : 1/0 ) t "scaledown", \
+    filename using 4:( strcol(2) eq "scaleup" ? $11 : 1/0 ) t "scaleup"
@@ -0,0 +1,60 @@
+#!/usr/bin/gnuplot
+
+# Plots for the results of scaling.sh, call it like this:
+# gnuplot -e "filename='scaling_algorithm.csv'" scaling.gnuplot
+# The columns are mode;levels;units;runtime;speedup;efficiency;weak_efficiency
+
+
+set terminal png size 1200,900
+
+set xlabel "# units"
+set grid
+
+if (!exists("filename")) filename='scaling_algorithm.csv'
+if (!exists("modes")) modes='flat sim multigrid elastic'
+if (!exists("levels")) levels='4 5 6'
+
+
+set datafile separator ";"
+set logscale x 2
+set key left top Left
+
+
+filename_out=filename.".speedup.png"
+set output filename_out
+set ylabel "speedup"
+set logscale y 2
+
+plot \
+    for [m in modes] for [l in levels] \
+        filename using 3:( strcol(1) eq m && strcol(2) eq l ? $5 : 1/0 ) with linespoints t m." ".l." levels", \
+    x with lines dt 2 t "ideal"
+
+
+filename_out=filename.".efficiency.png"
+set output filename_out
+set ylabel "parallel efficiency"
+unset logscale y
+set yrange [0:1.2]
+
+plot \
+    for [m in modes] for [l in levels] \
+        filename using 3:( strcol(1) eq m && strcol(2) eq l ? $6 : 1/0 ) with linespoints t m." ".l." levels (strong)", \
+    for [m in modes] for [l in levels] \
+        filename using 3:( strcol(1) eq m && strcol(2) eq l ? $7 : 1/0 ) with points t m." ".l." levels (weak)"
+
+
+# per region from all summary lines in scaling.csv, the columns are
+# mode;units;levels;tag;function_name;par;units;num_calls;min_runtime;mean_runtime;max_runtime;...
+if (!exists("summary")) summary='scaling.csv'
+if (!exists("regions")) regions='smoothen smoothen_wait smoothen_collect scaledown scaleup'
+
+filename_out=summary.".regions.png"
+set output filename_out
+set ylabel "time [s], max over units"
+set logscale y 10
+set autoscale y
+
+plot \
+    for [r in regions] for [m in modes] \
+        summary using 2:( strcol(5) eq r && strcol(1) eq m ? $11 : 1/0 ) with points t m." ".r
@@ -0,0 +1,147 @@
+#!/bin/bash
+
+# Strong and weak scaling study on a single machine. Runs multigrid3d for all
+# combinations of modes, unit counts and level counts (oversubscription allowed),
+# collects the MiniMon summaries (summary.csv, see MiniMon::print_summary) into
+# one table and computes speedup and parallel efficiency of the "algorithm" region.
+#
+# Results:
+#   scaling.csv        all summary lines, prefixed with mode;units;levels
+#   scaling_algorithm.csv
+#                      per mode, levels and units: max runtime over the units,
+#                      strong scaling speedup and efficiency relative to the
+#                      smallest unit count with the same levels, and weak scaling
+#                      efficiency relative to the smallest unit count with the
+#                      same number of elements per unit (units must be powers of 2)
+#   plots with scaling.gnuplot
+#
+# The MPI launcher can be set with the environment variable MPIRUN, default is
+# "mpirun --oversubscribe".
+#
+# With a baseline file (written with -s), runs that are slower than the baseline by
+# more than the threshold are reported and the exit code is 1.
+
+usage() {
+    echo "usage: $0 [-x <multigrid3d>] [-m \"<modes>\"] [-p \"<units>\"] [-l \"<levels>\"]"
+    echo "          [-b <baseline file>] [-s] [-t <threshold>] [-- <more multigrid3d options>]"
+    echo
+    echo " -x   path of the executable (default ./multigrid3d)"
+    echo " -m   modes out of flat sim multigrid elastic (default \"flat multigrid elastic\")"
+    echo " -p   unit counts (default \"1 2 4 8\")"
+    echo " -l   level counts (default \"4 5 6\")"
+    echo " -b   baseline file (default scaling_baseline.csv)"
+    echo " -s   store the results as the new baseline"
+    echo " -t   relative slowdown to report, default 0.1 for 10%"
+    exit 1
+}
+
+MPIRUN=${MPIRUN:-"mpirun --oversubscribe"}
+EXE=./multigrid3d
+MODES="flat multigrid elastic"
+UNITS="1 2 4 8"
+LEVELS="4 5 6"
+BASELINE=scaling_baseline.csv
+SAVE=0
+THRESHOLD=0.1
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -x) EXE=$2; shift 2 ;;
+        -m) MODES=$2; shift 2 ;;
+        -p) UNITS=$2; shift 2 ;;
+        -l) LEVELS=$2; shift 2 ;;
+        -b) BASELINE=$2; shift 2 ;;
+        -s) SAVE=1; shift ;;
+        -t) THRESHOLD=$2; shift 2 ;;
+        --) shift; break ;;
+        *) usage ;;
+    esac
+done
+EXTRA="$@"
+
+EXE=`readlink -f $EXE`
+[ -x "$EXE" ] || { echo "cannot execute $EXE"; exit 1; }
+
+WORK=`mktemp -d scaling.XXXXXX`
+
+echo "# mode;units;levels;tag;function_name;par;units;num_calls;min_runtime;mean_runtime;max_runtime;slowest_unit;imbalance" >scaling.csv
+
+for MODE in $MODES; do
+
+    case "$MODE" in
+        flat)      ARGS="-f" ;;
+        sim)       ARGS="--sim 0.1 0.1" ;;
+        multigrid) ARGS="" ;;
+        elastic)   ARGS="-e" ;;
+        *) echo "unknown mode $MODE"; exit 1 ;;
+    esac
+
+    for P in $UNITS; do
+        for L in $LEVELS; do
+
+            echo -n "$MODE with $P units and $L levels ... "
+            rm -f $WORK/summary.csv
+            ( cd $WORK && $MPIRUN -np $P $EXE $ARGS $EXTRA --no-unit-files $L >run_${MODE}_${P}_${L}.log 2>&1 )
+            if [ -f $WORK/summary.csv ]; then
+                grep -v "^#" $WORK/summary.csv | sed -e "s/^/$MODE;$P;$L;/" >>scaling.csv
+                echo "done"
+            else
+                echo "failed, see $WORK/run_${MODE}_${P}_${L}.log"
+            fi
+        done
+    done
+done
+
+# speedup and efficiency from the max runtime of "algorithm" over all units
+awk -F';' '
+    /^#/ { next }
+    $5 == "algorithm" {
+        key= $1 ";" $3 ";" $2
+        runtime[key]= $11
+        mode[key]= $1; levels[key]= $3; units[key]= $2
+        # elements per unit as 3*levels - log2(units)
+        weak[key]= $1 ";" ( 3*$3 - int( log($2)/log(2) + 0.5 ) )
+        if ( !( ($1 ";" $3) in pmin ) || $2 < pmin[$1 ";" $3] ) pmin[$1 ";" $3]= $2
+        if ( !( weak[key] in wmin ) || $2 < wmin[weak[key]] ) wmin[weak[key]]= $2
+    }
+    END {
+        print "# mode;levels;units;runtime;speedup;efficiency;weak_efficiency"
+        for ( key in runtime ) {
+            m= mode[key]; l= levels[key]; p= units[key]
+            p0= pmin[m ";" l]
+            t0= runtime[m ";" l ";" p0]
+            speedup= t0 / runtime[key]
+            w0= wmin[weak[key]]
+            # only with a run of the same size per unit on fewer units, else empty
+            wt= ""
+            if ( w0 < p ) {
+                wl= l - int( log(p/w0)/log(2) + 0.5 ) / 3
+                if ( wl == int( wl ) && (m ";" wl ";" w0) in runtime ) wt= runtime[m ";" wl ";" w0] / runtime[key]
+            }
+            print m ";" l ";" p ";" runtime[key] ";" speedup ";" speedup * p0 / p ";" wt
+        }
+    }' scaling.csv | sort -t';' -k1,1 -k2,2n -k3,3n >scaling_algorithm.csv
+
+tr ';' '\t' <scaling_algorithm.csv
+
+if [ 1 -eq $SAVE ]; then
+    cp scaling_algorithm.csv $BASELINE
+    echo "stored baseline $BASELINE"
+    exit 0
+fi
+
+[ -f $BASELINE ] || exit 0
+
+# compare to the baseline per mode, levels and units
+awk -F';' -v threshold=$THRESHOLD '
+    /^#/ { next }
+    FNR == NR { base[$1 ";" $2 ";" $3]= $4; next }
+    ( $1 ";" $2 ";" $3 ) in base {
+        b= base[$1 ";" $2 ";" $3]
+        if ( $4 > b * ( 1.0 + threshold ) ) {
+            printf( "SLOWDOWN %s with %s levels on %s units: %g s instead of %g s (+%.1f%%)\n",
+                $1, $2, $3, $4, b, 100.0 * ( $4 / b - 1.0 ) )
+            slow= 1
+        }
+    }
+    END { exit slow }' $BASELINE scaling_algorithm.csv
@@ -0,0 +1,375 @@
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+
+#include "solver.h"
+
+using std::cout;
+using std::endl;
+
+namespace dashmg {
+
+
+Solver::Solver( dash::Team& team ) : _team( &team ), _res( team ) {}
+
+
+Solver::~Solver() {
+
+    clear();
+}
+
+
+void Solver::clear() {
+
+    /* the levels are deleted collectively by the teams that created them,
+    passive units in elastic mode only own the finer levels */
+    for ( Level* level : _levels ) {
+        delete level;
+    }
+    _levels.clear();
+}
+
+
+void Solver::setup( uint32_t howmanylevels, const std::array< double, 3 >& dim,
+                    const std::array< bool, 3 >& mirror, uint32_t split,
+                    const Decomposition& decomposition ) {
+
+    setup( {{ level_extent( howmanylevels, mirror[0] ), level_extent( howmanylevels, mirror[1] ),
+        level_extent( howmanylevels, mirror[2] ) }}, dim, mirror, split, decomposition );
+}
+
+
+void Solver::setup( const std::array< size_t, 3 >& extents, const std::array< double, 3 >& dim,
+                    const std::array< bool, 3 >& mirror, uint32_t split,
+                    const Decomposition& decomposition, bool semicoarsening ) {
+    SCOREP_USER_FUNC()
+
+    clear();
+
+    dash::Team& team= *_team;
+
+    TeamSpecT teamspec= make_teamspec( team.size(), extents, decomposition );
+
+    /* grid spacing of the finest level, see Level */
+    std::array< double, 3 > h;
+    for ( uint32_t d= 0; d < 3; ++d ) {
+        h[d]= dim[d] / ( ( mirror[d] ? 2*extents[d]-1 : extents[d] ) + 1 );
+    }
+
+    /* the levels of the entire team, the finest one included. In elastic mode, every
+    following team gets the transfer level and split levels more */
+    size_t maxlevels= ( 0 < split && 1 < team.size() ) ? split : 0;
+    std::vector<LevelPlan> plan= plan_levels( extents, h, mirror, teamspec, maxlevels, semicoarsening,
+        decomposition.balance );
+
+    if ( 0 == team.myid() ) {
+
+        cout << "setup " << ( 0 < split ? "elastic " : "" ) <<
+            ( semicoarsening ? "semi-coarsening " : "" ) << "multigrid hierarchy with " <<
+            team.size() << " units for a finest grid of " <<
+            extents[0] << "×" << extents[1] << "×" << extents[2];
+        if ( 0 < split ) {
+            cout << " splitting every " << split << (split == 1 ? "st" : split == 2 ? "nd" : split == 3 ? "rd" : "th") << " level";
+        }
+        cout << endl;
+    }
+
+    /* finest grid needs to be larger than 2*teamspec per dimension,
+    that means local grid is >= 2 elements */
+    assert( extents[0] >= 2*teamspec.num_units(0) );
+    assert( extents[1] >= 2*teamspec.num_units(1) );
+    assert( extents[2] >= 2*teamspec.num_units(2) );
+
+    /* create all grid levels, starting with the finest and ending with the coarsest one
+    of the plan. The finest level is outside the loop because it is always done by the
+    entire team */
+
+    if ( 0 == team.myid() ) {
+        cout << "finest level is " <<
+            extents[0] << "×" << extents[1] << "×" << extents[2] <<
+            " distributed over " <<
+            teamspec.num_units(0) << "×" <<
+            teamspec.num_units(1) << "×" <<
+            teamspec.num_units(2) << " units" << endl;
+    }
+
+    _levels.push_back( new Level( dim[0], dim[1], dim[2],
+        extents[0], extents[1], extents[2],
+        team, teamspec, mirror, plan[0].blocks ) );
+
+    /* only do initgrid on the finest level, use scaledownboundary for all others */
+    initboundary( *_levels.back() );
+
+    team.barrier();
+
+    size_t next= 1;
+    TeamSpecT localteamspec= teamspec;
+    while ( true ) {
+
+        /* below the threshold, every unit gets the entire level and runs the coarser
+        levels alone without any communication, see replicate() */
+        Level& back= *_levels.back();
+        dash::Team& backteam= back.src_grid->team();
+        if ( 1 < _levels.size() && 1 < backteam.size() && back.src_grid->size() <= decomposition.replicate ) {
+
+            dash::Team& single= backteam.split( backteam.size() );
+            std::array< size_t, 3 > backextents= {{ back.src_grid->extent(0),
+                back.src_grid->extent(1), back.src_grid->extent(2) }};
+
+            size_t block= 0;
+            for ( size_t u= 0; u < backteam.size(); ++u ) {
+                block= std::max( block, (size_t) back.src_grid->pattern().local_size( dash::team_unit_t( u ) ) );
+            }
+
+            localteamspec= make_teamspec( single.size(), backextents, decomposition );
+            maxlevels= 0;
+            plan= plan_levels( backextents, {{ back.hz, back.hy, back.hx }}, mirror, localteamspec,
+                maxlevels, semicoarsening, decomposition.balance );
+            next= 1;
+
+            if ( 0 == backteam.myid() ) {
+                cout << "replicate level of " << backextents[0] << "×" << backextents[1] << "×" <<
+                    backextents[2] << " on all " << backteam.size() << " units" << endl;
+            }
+
+            _levels.push_back( new Level( back, backextents[0], backextents[1], backextents[2],
+                single, localteamspec, plan[0].blocks ) );
+            _levels.back()->replica.reset( new Replica( backteam, single, block ) );
+            initboundary_zero( *_levels.back() );
+            continue;
+        }
+
+        if ( next < plan.size() ) {
+
+            dash::Team& currentteam= _levels.back()->src_grid->team();
+            const LevelPlan& lp= plan[next++];
+
+            /* do not try to allocate >= 8GB per core -- try to prevent myself
+            from running too big a simulation on my laptop */
+            assert( lp.extents[0] * lp.extents[1] * lp.extents[2] < currentteam.size() * (1<<27) );
+
+            _levels.push_back( new Level( *_levels.back(),
+                lp.extents[0], lp.extents[1], lp.extents[2],
+                currentteam, localteamspec, lp.blocks ) );
+
+            /* scaledown boundary instead of initializing it from the same
+            procedure, because this is very prone to subtle mistakes which
+            makes the entire multigrid algorithm misbehave. */
+            //scaledownboundary( previouslevel, *_levels.back() );
+
+            initboundary_zero( *_levels.back() );
+            continue;
+        }
+
+        /* the plan of this team is done, it was either coarsened as far as possible or
+        it is split now in elastic mode */
+        dash::Team& previousteam= _levels.back()->src_grid->team();
+        if ( 0 == maxlevels || plan.size() < maxlevels ) break;
+
+        dash::Team& currentteam= previousteam.split(8);
+        const Level& last= *_levels.back();
+        std::array< size_t, 3 > lastextents= {{ last.src_grid->extent(0),
+            last.src_grid->extent(1), last.src_grid->extent(2) }};
+
+        /* a new team starts with the transfer level of the previous extents, the
+        coarser levels of the same team keep its unit arrangement, see make_teamspec() */
+        localteamspec= make_teamspec( currentteam.size(), lastextents, decomposition );
+        maxlevels= ( 1 < currentteam.size() ) ? split+1 : 0;
+        plan= plan_levels( lastextents, {{ last.hz, last.hy, last.hx }}, mirror, localteamspec,
+            maxlevels, semicoarsening, decomposition.balance );
+        next= 1;
+
+        /* this is the real iteration condition for this loop! */
+        if ( plan.size() < 2 ) break;
+
+        if ( 0 != currentteam.position() ) {
+
+            /* this is a passive unit not taking part in the subteam that
+            handles the coarser grids. insert a dummy entry in the vector
+            of levels to signal that this is not the coarsest level globally. */
+            _levels.push_back( NULL );
+
+            break;
+        }
+
+        if ( 0 == currentteam.myid() ) {
+            cout << "team of " << currentteam.size() << " units arranged as " <<
+                localteamspec.num_units(0) << "×" <<
+                localteamspec.num_units(1) << "×" <<
+                localteamspec.num_units(2) << endl;
+        }
+
+        /* the team working on the following grid layers has just
+        been reduced. Therefore, we add an additional grid with the
+        same size as the previous one but for the reduced team. Then,
+        copying the data from the domain of the larger team to the
+        domain of the smaller team is easy. */
+
+        _levels.push_back( new Level( last, lastextents[0], lastextents[1], lastextents[2],
+            currentteam, localteamspec, plan[0].blocks ) );
+        initboundary_zero( *_levels.back() );
+    }
+
+    /* here all units and all teams meet again, those that were active for the coarsest
+    levels and those that were dormant */
+    team.barrier();
+
+    /* every unit only takes part for the levels of its teams */
+    for ( size_t l= 0; l < _levels.size() && NULL != _levels[l]; ++l ) {
+
+        Level& level= *_levels[l];
+        report_imbalance( level, l );
+
+        if ( l+1 < _levels.size() && NULL != _levels[l+1] ) setup_prolongation( *_levels[l+1], level );
+
+        /* on the levels where the halo messages are latency bound, see PackedHalo */
+        if ( 1 < level.src_grid->team().size() && largest_face_bytes( level ) <= decomposition.packed ) {
+
+            level.enable_packed_halo();
+            if ( 0 == level.src_grid->team().myid() && 0 == level.src_grid->team().position() ) {
+                cout << "packed halo exchange for level " << l << endl;
+            }
+        }
+    }
+
+    team.barrier();
+
+    /* Fill finest level. Strictly, we don't need to set any initial values here
+    but we do it for demonstration in the graphical output */
+    initgrid( *_levels.front() );
+
+    team.barrier();
+
+    _res.reset( team );
+}
+
+
+void Solver::setup_single( uint32_t howmanylevels, const std::array< double, 3 >& dim,
+                           const std::array< bool, 3 >& mirror, const Decomposition& decomposition ) {
+
+    setup_single( {{ level_extent( howmanylevels, mirror[0] ), level_extent( howmanylevels, mirror[1] ),
+        level_extent( howmanylevels, mirror[2] ) }}, dim, mirror, decomposition );
+}
+
+
+void Solver::setup_single( const std::array< size_t, 3 >& extents, const std::array< double, 3 >& dim,
+                           const std::array< bool, 3 >& mirror, const Decomposition& decomposition ) {
+
+    clear();
+
+    dash::Team& team= *_team;
+
+    TeamSpecT teamspec= make_teamspec( team.size(), extents, decomposition );
+
+    if ( 0 == team.myid() ) {
+
+        cout << "setup single grid of " <<
+            extents[0] << "×" << extents[1] << "×" << extents[2] <<
+            " with " << teamspec.num_units(0) << "×" << teamspec.num_units(1) << "×" <<
+            teamspec.num_units(2) << " units" << endl;
+    }
+
+    _levels.push_back( new Level( dim[0], dim[1], dim[2],
+        extents[0], extents[1], extents[2],
+        team, teamspec, mirror ) );
+
+    team.barrier();
+
+    initboundary( *_levels.back() );
+
+    initgrid( *_levels.back() );
+
+    team.barrier();
+
+    _res.reset( team );
+}
+
+
+void Solver::reset_solution() {
+
+    dash::fill( finest().src_grid->begin(), finest().src_grid->end(), ValueT( 0.0 ) );
+    finest().src_grid->barrier();
+}
+
+
+double Solver::solve( double eps, double adapt, uint32_t beta, uint32_t gamma ) {
+    SCOREP_USER_FUNC()
+
+    if ( 0 == _team->myid()  ) {
+        cout << "start " << ( 1 == gamma ? "v" : "w" ) << "-cycle with res " << eps << endl << endl;
+    }
+    recursive_cycle( _levels.begin(), _levels.end(), beta, gamma, eps, adapt, _res );
+    _team->barrier();
+
+    if ( 0 == _team->myid()  ) {
+        cout << "final smoothing with res " << eps << endl;
+    }
+    smoothen_final( finest(), eps, _res );
+
+    _team->barrier();
+
+    return _res.get();
+}
+
+
+double Solver::cycle( double eps, double adapt, uint32_t beta, uint32_t gamma ) {
+    SCOREP_USER_FUNC()
+
+    recursive_cycle( _levels.begin(), _levels.end(), beta, gamma, eps, adapt, _res );
+    _team->barrier();
+
+    return _res.get();
+}
+
+
+void Solver::skeleton( uint32_t beta, uint32_t gamma ) {
+    SCOREP_USER_FUNC()
+
+    if ( 0 == _team->myid()  ) {
+        cout << "start skeleton " << ( 1 == gamma ? "v" : "w" ) << "-cycle with " << beta << " sweeps per level" << endl;
+    }
+    skeleton_cycle( _levels.begin(), _levels.end(), beta, gamma, _res );
+    _team->barrier();
+
+    for ( uint32_t j= 0; j < beta; ++j ) skeleton_smoothen( finest(), _res );
+
+    _team->barrier();
+}
+
+
+double Solver::iterate( double eps, uint32_t maxsteps ) {
+
+    uint32_t j= 0;
+    _res.reset( *_team );
+    while ( _res.get() > eps && j < maxsteps ) {
+
+        smoothen( finest(), _res );
+
+        j++;
+    }
+    if ( 0 == _team->myid() ) {
+        cout << "smoothing: " << j << " steps finest with residual " << _res.get() << endl;
+    }
+
+    return _res.get();
+}
+
+
+double Solver::step( double dt ) {
+
+    return smoothen( finest(), _res, dt );
+}
+
+
+double Solver::max_dt() const {
+
+    return _levels.front()->max_dt();
+}
+
+
+bool Solver::check_symmetry( double eps ) {
+
+    return ::check_symmetry( finest(), eps );
+}
+
+} /* namespace dashmg */
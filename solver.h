@@ -0,0 +1,152 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <array>
+#include <vector>
+
+#include "multigrid.h"
+
+namespace dashmg {
+
+/* Reusable solver: setup() builds the grid hierarchy with all halos and operators
+once, then solve(), iterate() or step() can be called as often as needed, e.g. in
+a time loop. Every call continues from the current solution on the finest grid.
+All methods are collective over the team given to the constructor. */
+class Solver {
+
+public:
+
+    explicit Solver( dash::Team& team= dash::Team::All() );
+    ~Solver();
+
+    Solver( const Solver& ) = delete;
+    Solver& operator=( const Solver& ) = delete;
+
+    /* build the hierarchy for a finest grid of 2^l -1 inner points per dimension
+    (2^(l-1) in mirrored dimensions, see Level::mirror) down to the coarsest grid that
+    still has 2 points per unit and dimension. dim are the physical dimensions in
+    meters. With split > 0, the team is split every split levels (elastic mode).
+    decomposition arranges the units of every team, see make_teamspec().
+    The boundary is set with initboundary(), the initial solution is 0.0. */
+    void setup( uint32_t howmanylevels, const std::array< double, 3 >& dim,
+                const std::array< bool, 3 >& mirror= {{ false, false, false }}, uint32_t split= 0,
+                const Decomposition& decomposition= Decomposition() );
+
+    /* same as above for a finest grid of any extents of at least 2 points per unit and
+    dimension. Odd extents are coarsened to (n-1)/2 like 2^l -1, even ones to n/2, see
+    plan_levels(). With semicoarsening, only the dimensions with the finest grid spacing
+    are coarsened until the spacing is about the same in all dimensions. */
+    void setup( const std::array< size_t, 3 >& extents, const std::array< double, 3 >& dim,
+                const std::array< bool, 3 >& mirror= {{ false, false, false }}, uint32_t split= 0,
+                const Decomposition& decomposition= Decomposition(), bool semicoarsening= false );
+
+    /* same as setup() but only the finest grid, for flat iteration and simulation */
+    void setup_single( uint32_t howmanylevels, const std::array< double, 3 >& dim,
+                const std::array< bool, 3 >& mirror= {{ false, false, false }},
+                const Decomposition& decomposition= Decomposition() );
+    void setup_single( const std::array< size_t, 3 >& extents, const std::array< double, 3 >& dim,
+                const std::array< bool, 3 >& mirror= {{ false, false, false }},
+                const Decomposition& decomposition= Decomposition() );
+
+    /* set the boundary values on the finest grid from fun( coords ) for all global
+    halo coordinates. The coarser grids keep their 0.0 boundary for the correction. */
+    template< typename F >
+    void set_boundary( const F& fun ) {
+
+        finest().src_halo->set_custom_halos( fun );
+        finest().dst_halo->set_custom_halos( fun );
+        _team->barrier();
+    }
+
+    /* set the right hand side of the finest grid from fun( z, y, x ) in global coordinates */
+    template< typename F >
+    void set_rhs( const F& fun ) {
+
+        MatrixT& rhs= *finest().rhs_grid;
+        const auto& ext= rhs.local.extents();
+        const auto& corner= rhs.pattern().global( {0,0,0} );
+        for ( size_t z= 0; z < ext[0]; ++z ) {
+            for ( size_t y= 0; y < ext[1]; ++y ) {
+                for ( size_t x= 0; x < ext[2]; ++x ) {
+                    rhs.local[z][y][x]= fun( corner[0]+z, corner[1]+y, corner[2]+x );
+                }
+            }
+        }
+        _team->barrier();
+    }
+
+    /* set the current solution on the finest grid to 0.0 */
+    void reset_solution();
+
+    /* multigrid solve, cycles with gamma recursions per level (1 is a V cycle, 2 a W cycle)
+    with at most beta smoothing steps per level and final smoothing until the residual is
+    below eps. See smoothen_adaptive() for adapt. Returns the final residual. */
+    double solve( double eps, double adapt= 0.0, uint32_t beta= 20, uint32_t gamma= 2 );
+
+    /* a single cycle of solve() without the final smoothing, eps only applies to the
+    coarsest grid. Returns the residual of the last sweep on the finest grid. */
+    double cycle( double eps, double adapt= 0.0, uint32_t beta= 20, uint32_t gamma= 2 );
+
+    /* only the communication of solve(): the same cycle over the same levels and
+    teams with halo exchanges, Allreduce and transfers but without stencil math,
+    always beta sweeps per smoothing and then beta sweeps instead of the final
+    smoothing. See skeleton_cycle(). */
+    void skeleton( uint32_t beta= 20, uint32_t gamma= 2 );
+
+    /* flat Jacobi iteration on the finest grid until residual is below eps */
+    double iterate( double eps, uint32_t maxsteps= 100000 );
+
+    /* one explicit time step of size dt on the finest grid, for the simulation mode */
+    double step( double dt );
+
+    /* the maximum time step of the finest grid according to the stability condition */
+    double max_dt() const;
+
+    /* result accessors */
+    double residual() const { return _res.get(); }
+    Level& finest() { return *_levels.front(); }
+    const std::vector<Level*>& levels() const { return _levels; }
+    dash::Team& team() { return *_team; }
+
+    /* solution at global coordinates of the full grid, global access */
+    ValueT value_at( size_t z, size_t y, size_t x ) { return full_value_at( finest(), z, y, x ); }
+
+    /* maximum norm of the difference between the solution on the finest grid and
+    exact( z, y, x ) in global coordinates, collective over the team */
+    template< typename F >
+    double max_error( const F& exact ) {
+
+        MatrixT& grid= *finest().src_grid;
+        const auto& ext= grid.local.extents();
+        const auto& corner= grid.pattern().global( {0,0,0} );
+        double err= 0.0;
+        for ( size_t z= 0; z < ext[0]; ++z ) {
+            for ( size_t y= 0; y < ext[1]; ++y ) {
+                for ( size_t x= 0; x < ext[2]; ++x ) {
+                    err= std::max( err, maxabs( grid.local[z][y][x] -
+                        ValueT( exact( corner[0]+z, corner[1]+y, corner[2]+x ) ) ) );
+                }
+            }
+        }
+        return team_max( *_team, err );
+    }
+
+    /* check the solution on the finest grid for mirror symmetry, see check_symmetry(),
+    collective over the team */
+    bool check_symmetry( double eps );
+
+private:
+
+    void clear();
+
+    dash::Team* _team;
+    Allreduce _res;
+
+    /* finest level first, for passive units in elastic mode the last entry is NULL,
+    see recursive_cycle() */
+    std::vector<Level*> _levels;
+};
+
+} /* namespace dashmg */
+
+#endif /* SOLVER_H */